@@ -12,3 +12,6 @@
 #include <vector>
 #include <string>
 #include <string_view>
+#include <random>
+#include <map>
+#include <list>
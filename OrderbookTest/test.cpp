@@ -1,6 +1,16 @@
 #include "pch.h"
 
 #include "../backend/src/Orderbook.cpp"
+#include "../backend/src/LadderOrderbook.cpp"
+#include "../backend/src/SimdKernels.cpp"
+#include "../backend/src/BinarySearchOrderbook.cpp"
+#include "../backend/src/LatencyHistogram.cpp"
+#include "../backend/src/BenchmarkReport.cpp"
+#include "../backend/src/OrderFlowGenerator.cpp"
+#include "../backend/src/OrderJournal.cpp"
+#include "../backend/src/MatchingEngine.cpp"
+#include "../backend/src/OrderGateway.cpp"
+#include "../backend/include/ReplayDriver.h"
 
 namespace googletest = ::testing;
 
@@ -183,8 +193,8 @@ public:
 	const static inline std::filesystem::path TestFolderPath{ Root / TestFolder };
 };
 
-TEST_P(OrderbookTestsFixture, OrderbookTestSuite) {
-	const auto file = OrderbookTestsFixture::TestFolderPath / GetParam();
+template <typename OrderbookType>
+void RunOrderbookTest(const std::filesystem::path& file) {
 
 	InputHandler handler;
 	const auto [updates, result] = handler.GetInformations(file);
@@ -208,7 +218,7 @@ TEST_P(OrderbookTestsFixture, OrderbookTestSuite) {
 		);
 	};
 
-	Orderbook orderbook;
+	OrderbookType orderbook;
 	for (const auto& update : updates) {
 		switch (update.type_)
 		{
@@ -238,6 +248,18 @@ TEST_P(OrderbookTestsFixture, OrderbookTestSuite) {
 	ASSERT_EQ(orderbookInfos.GetAsks().size(), result.askCount_);
 }
 
+TEST_P(OrderbookTestsFixture, OrderbookTestSuite) {
+	RunOrderbookTest<Orderbook>(OrderbookTestsFixture::TestFolderPath / GetParam());
+}
+
+TEST_P(OrderbookTestsFixture, LadderOrderbookTestSuite) {
+	RunOrderbookTest<LadderOrderbook>(OrderbookTestsFixture::TestFolderPath / GetParam());
+}
+
+TEST_P(OrderbookTestsFixture, BinarySearchOrderbookTestSuite) {
+	RunOrderbookTest<BinarySearchOrderbook>(OrderbookTestsFixture::TestFolderPath / GetParam());
+}
+
 INSTANTIATE_TEST_CASE_P(Tests, OrderbookTestsFixture, googletest::ValuesIn({
 	"Match_GoodTillCancel.txt",
 	"Match_FillAndKill.txt",
@@ -247,3 +269,1137 @@ INSTANTIATE_TEST_CASE_P(Tests, OrderbookTestsFixture, googletest::ValuesIn({
 	"Modify_Side.txt",
 	"Match_Market.txt"
 }));
+
+namespace {
+	constexpr std::size_t STRESS_READER_COUNT = 8;
+	constexpr std::uint64_t STRESS_WRITE_COUNT = 200'000;
+
+	template <typename Reader>
+	std::size_t RunReaders(std::atomic<bool>& done, Reader reader) {
+		std::atomic<std::size_t> failures{ 0 };
+		std::vector<std::thread> readers;
+
+		for (std::size_t i = 0; i < STRESS_READER_COUNT; ++i) {
+			readers.emplace_back([&] {
+				while (!done.load(std::memory_order_acquire)) {
+					if (!reader())
+						failures.fetch_add(1, std::memory_order_relaxed);
+				}
+			});
+		}
+
+		for (auto& thread : readers)
+			thread.join();
+
+		return failures.load();
+	}
+}
+
+TEST(SeqLockTests, ReadersNeverSeeTornValues) {
+	struct Payload {
+		std::array<std::uint64_t, 64> words_{};
+	};
+
+	SeqLock<Payload> seqLock;
+	std::atomic<bool> done{ false };
+
+	std::thread writer([&] {
+		Payload payload;
+		for (std::uint64_t version = 1; version <= STRESS_WRITE_COUNT; ++version) {
+			payload.words_.fill(version);
+			seqLock.Store(payload);
+		}
+		done.store(true, std::memory_order_release);
+	});
+
+	const auto failures = RunReaders(done, [&] {
+		const Payload payload = seqLock.Load();
+		return std::all_of(payload.words_.begin(), payload.words_.end(),
+			[&](std::uint64_t word) { return word == payload.words_.front(); });
+	});
+
+	writer.join();
+
+	ASSERT_EQ(failures, 0);
+	ASSERT_EQ(seqLock.GetVersion(), STRESS_WRITE_COUNT + 1);
+}
+
+TEST(OrderbookPublishTests, ReadersNeverSeeTornSnapshots) {
+	constexpr Price MID_PRICE = 1'000;
+	constexpr Price SPREAD = 32;
+
+	Orderbook orderbook;
+	orderbook.SetPublishDepth(OrderbookDepthInfos::MAX_DEPTH);
+	std::atomic<bool> done{ false };
+
+	// Keeps a window of resting orders on both sides, cancelling the oldest order for each new one.
+	std::thread writer([&] {
+		constexpr OrderId WINDOW = 64;
+
+		for (OrderId orderId = 0; orderId < STRESS_WRITE_COUNT; ++orderId) {
+			const Side side = orderId % 2 ? Side::Sell : Side::Buy;
+			const Price offset = 1 + static_cast<Price>(orderId % SPREAD);
+			const Price price = side == Side::Buy ? MID_PRICE - offset : MID_PRICE + offset;
+
+			orderbook.AddOrder(OrderType::GoodTillCancel, orderId, side, price, 1 + orderId % 7);
+
+			if (orderId >= WINDOW)
+				orderbook.CancelOrder(orderId - WINDOW);
+		}
+		done.store(true, std::memory_order_release);
+	});
+
+	const auto failures = RunReaders(done, [&] {
+		const OrderbookDepthInfos infos = orderbook.GetPublishedOrderInfos();
+		const auto bids = infos.GetBids();
+		const auto asks = infos.GetAsks();
+
+		if (bids.size() > OrderbookDepthInfos::MAX_DEPTH || asks.size() > OrderbookDepthInfos::MAX_DEPTH)
+			return false;
+
+		for (std::size_t i = 0; i < bids.size(); ++i) {
+			if (bids[i].quantity_ == 0 || bids[i].price_ >= MID_PRICE) return false;
+			if (i > 0 && bids[i - 1].price_ <= bids[i].price_) return false;
+		}
+
+		for (std::size_t i = 0; i < asks.size(); ++i) {
+			if (asks[i].quantity_ == 0 || asks[i].price_ <= MID_PRICE) return false;
+			if (i > 0 && asks[i - 1].price_ >= asks[i].price_) return false;
+		}
+
+		return true;
+	});
+
+	writer.join();
+
+	ASSERT_EQ(failures, 0);
+}
+
+void AssertDepthMatchesSnapshot(const Orderbook& orderbook, Price probe) {
+	const auto infos = orderbook.GetOrderInfos();
+
+	Quantity bidsAbove = 0;
+	for (const auto& level : infos.GetBids())
+		bidsAbove += level.price_ >= probe ? level.quantity_ : 0;
+
+	Quantity asksBelow = 0;
+	for (const auto& level : infos.GetAsks())
+		asksBelow += level.price_ <= probe ? level.quantity_ : 0;
+
+	ASSERT_EQ(orderbook.QuantityUpTo(Side::Buy, probe), bidsAbove);
+	ASSERT_EQ(orderbook.QuantityUpTo(Side::Sell, probe), asksBelow);
+
+	Quantity swept = 0;
+	for (const auto& level : infos.GetAsks()) {
+		swept += level.quantity_;
+		ASSERT_EQ(orderbook.PriceForQuantity(Side::Sell, swept), level.price_);
+	}
+	ASSERT_FALSE(orderbook.PriceForQuantity(Side::Sell, swept + 1).has_value());
+
+	swept = 0;
+	for (const auto& level : infos.GetBids()) {
+		swept += level.quantity_;
+		ASSERT_EQ(orderbook.PriceForQuantity(Side::Buy, swept), level.price_);
+	}
+	ASSERT_FALSE(orderbook.PriceForQuantity(Side::Buy, swept + 1).has_value());
+}
+
+TEST(OrderbookDepthIndexTests, MatchesLevelSnapshots) {
+	constexpr Price TICK = 1'000'000;
+	constexpr Price MID_PRICE = 6'000'000'000'000;
+	constexpr OrderId ORDER_COUNT = 20'000;
+
+	Orderbook orderbook;
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<Price> offsetDist(0, 400);
+	std::uniform_int_distribution<Quantity> qtyDist(1, 100);
+
+	for (OrderId orderId = 0; orderId < ORDER_COUNT; ++orderId) {
+		// Crossing prices so matching, partial fills and the index rebuilds all get exercised.
+		const Side side = orderId % 2 ? Side::Sell : Side::Buy;
+		const Price price = MID_PRICE - 200 * TICK + offsetDist(rng) * TICK;
+		orderbook.AddOrder(OrderType::GoodTillCancel, orderId, side, price, qtyDist(rng));
+
+		if (orderId % 3 == 0)
+			orderbook.CancelOrder(orderId / 2);
+
+		if (orderId % 1'000 != 0)
+			continue;
+
+		AssertDepthMatchesSnapshot(orderbook, MID_PRICE - 200 * TICK + offsetDist(rng) * TICK);
+	}
+}
+
+TEST(OrderbookDepthIndexTests, WidePriceSpreads) {
+	// The tick falls to 1 and the span to billions of levels, more than the index may hold.
+	Orderbook orderbook;
+	orderbook.AddOrder(OrderType::GoodTillCancel, 1, Side::Buy, 1, 10);
+	orderbook.AddOrder(OrderType::GoodTillCancel, 2, Side::Sell, 4'000'000'000, 10);
+	orderbook.AddOrder(OrderType::GoodTillCancel, 3, Side::Buy, 2, 10);
+
+	ASSERT_EQ(orderbook.Size(), 3);
+	AssertDepthMatchesSnapshot(orderbook, 1);
+	AssertDepthMatchesSnapshot(orderbook, 4'000'000'000);
+	ASSERT_TRUE(orderbook.AddOrder(OrderType::FillOrKill, 4, Side::Sell, 1, 30).empty());
+	ASSERT_EQ(orderbook.AddOrder(OrderType::FillOrKill, 5, Side::Sell, 1, 15).size(), 2);
+
+	// Once the book empties the index starts over.
+	orderbook.CancelOrder(1);
+	orderbook.CancelOrder(2);
+	ASSERT_EQ(orderbook.Size(), 0);
+	orderbook.AddOrder(OrderType::GoodTillCancel, 6, Side::Buy, 100, 10);
+	orderbook.AddOrder(OrderType::GoodTillCancel, 7, Side::Buy, 99, 10);
+	AssertDepthMatchesSnapshot(orderbook, 99);
+
+	// Co-prime prices far apart, mixed with a busy book around a mid price, against a book without the index.
+	Orderbook indexed;
+	BinarySearchOrderbook reference;
+	std::mt19937_64 rng(42);
+	const std::array<Price, 4> farPrices = { 7, 13, 3'999'999'937, 4'000'000'007 };
+
+	for (OrderId orderId = 0; orderId < 20'000; ++orderId) {
+		const Side side = rng() % 2 ? Side::Sell : Side::Buy;
+		const Price price = rng() % 50 == 0 ? farPrices[rng() % farPrices.size()]
+			: side == Side::Buy ? 1'000'003 - rng() % 40 : 1'000'003 + 1 + rng() % 40;
+		const OrderType orderType = rng() % 5 == 0 ? OrderType::FillOrKill : OrderType::GoodTillCancel;
+		const Quantity quantity = 1 + rng() % 100;
+
+		ASSERT_EQ(indexed.AddOrder(orderType, orderId, side, price, quantity).size(),
+			reference.AddOrder(orderType, orderId, side, price, quantity).size());
+
+		if (orderId % 3 == 0) {
+			const OrderId cancelled = rng() % (orderId + 1);
+			indexed.CancelOrder(cancelled);
+			reference.CancelOrder(cancelled);
+		}
+
+		if (orderId % 500 == 0)
+			AssertDepthMatchesSnapshot(indexed, farPrices[rng() % farPrices.size()]);
+	}
+
+	ASSERT_EQ(indexed.Size(), reference.Size());
+}
+
+TEST(ExecutionSinkTests, StreamsTheSameTradesAndLevels) {
+	struct RecordingSink : IExecutionSink {
+		Trades trades_;
+		std::map<std::pair<Side, Price>, Quantity> levels_;
+
+		void OnTrade(const Trade& trade) override { trades_.push_back(trade); }
+		void OnLevelChanged(Side side, Price price, Quantity quantity) override {
+			if (quantity == 0)
+				levels_.erase({ side, price });
+			else
+				levels_[{ side, price }] = quantity;
+		}
+	};
+
+	Orderbook returning;
+	Orderbook streaming;
+	RecordingSink sink;
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<Price> priceDist(100, 140);
+	std::uniform_int_distribution<Quantity> qtyDist(1, 100);
+
+	for (OrderId orderId = 0; orderId < 5'000; ++orderId) {
+		const Side side = orderId % 2 ? Side::Sell : Side::Buy;
+		const OrderType orderType = orderId % 7 == 0 ? OrderType::FillAndKill : orderId % 11 == 0 ? OrderType::Market : OrderType::GoodTillCancel;
+		const Price price = priceDist(rng);
+		const Quantity quantity = qtyDist(rng);
+
+		const Trades trades = returning.AddOrder(orderType, orderId, side, price, quantity);
+		sink.trades_.clear();
+		streaming.AddOrder(orderType, orderId, side, price, quantity, sink);
+
+		ASSERT_EQ(trades.size(), sink.trades_.size());
+		for (std::size_t i = 0; i < trades.size(); ++i) {
+			ASSERT_EQ(trades[i].GetBidTrade().orderId_, sink.trades_[i].GetBidTrade().orderId_);
+			ASSERT_EQ(trades[i].GetAskTrade().orderId_, sink.trades_[i].GetAskTrade().orderId_);
+			ASSERT_EQ(trades[i].GetBidTrade().quantity_, sink.trades_[i].GetBidTrade().quantity_);
+		}
+
+		if (orderId % 3 == 0) {
+			returning.CancelOrder(orderId / 2);
+			streaming.CancelOrder(orderId / 2, sink);
+		}
+	}
+
+	std::map<std::pair<Side, Price>, Quantity> levels;
+	const auto infos = returning.GetOrderInfos();
+	for (const auto& level : infos.GetBids())
+		levels[{ Side::Buy, level.price_ }] = level.quantity_;
+	for (const auto& level : infos.GetAsks())
+		levels[{ Side::Sell, level.price_ }] = level.quantity_;
+
+	ASSERT_EQ(levels, sink.levels_);
+}
+
+TEST(OrderbookBatchTests, MatchesOneCallPerOrder) {
+	Orderbook single;
+	Orderbook batched;
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<Price> priceDist(100, 140);
+	std::uniform_int_distribution<Quantity> qtyDist(1, 100);
+
+	std::vector<OrderCommand> orders;
+	for (OrderId orderId = 0; orderId < 2'000; ++orderId) {
+		const Side side = orderId % 2 ? Side::Sell : Side::Buy;
+		orders.push_back(OrderCommand{ OrderCommandType::Add, OrderType::GoodTillCancel, side, 0, orderId, priceDist(rng), qtyDist(rng) });
+	}
+
+	std::size_t singleTrades = 0;
+	for (const auto& order : orders)
+		singleTrades += single.AddOrder(order.orderType_, order.orderId_, order.side_, order.price_, order.quantity_).size();
+
+	ASSERT_EQ(batched.AddOrders(orders).size(), singleTrades);
+	ASSERT_EQ(batched.Size(), single.Size());
+
+	// Every other id, with duplicates and unknown ids mixed in.
+	OrderIds orderIds;
+	for (OrderId orderId = 0; orderId < 3'000; orderId += 2)
+		orderIds.insert(orderIds.end(), 2, orderId);
+
+	for (const auto& orderId : orderIds)
+		single.CancelOrder(orderId);
+	batched.CancelOrders(orderIds);
+
+	ASSERT_EQ(batched.Size(), single.Size());
+	ASSERT_EQ(batched.GetOrderInfos().GetBids().size(), single.GetOrderInfos().GetBids().size());
+	ASSERT_EQ(batched.GetOrderInfos().GetAsks().size(), single.GetOrderInfos().GetAsks().size());
+}
+
+template <typename OrderbookType>
+void RunModifyKeepsPriorityTest() {
+	OrderbookType orderbook;
+	orderbook.AddOrder(OrderType::GoodTillCancel, 1, Side::Buy, 100, 10);
+	orderbook.AddOrder(OrderType::GoodTillCancel, 2, Side::Buy, 100, 10);
+	orderbook.AddOrder(OrderType::GoodTillCancel, 3, Side::Buy, 100, 10);
+
+	// Reducing keeps order 2 ahead of order 3, growing order 1 requeues it at the back of the level.
+	ASSERT_TRUE(orderbook.ModifyOrder(OrderModify{ 2, Side::Buy, 100, 4 }).empty());
+	ASSERT_TRUE(orderbook.ModifyOrder(OrderModify{ 1, Side::Buy, 100, 20 }).empty());
+	ASSERT_EQ(orderbook.GetOrderInfos().GetBids()[0].quantity_, 34);
+
+	const Trades trades = orderbook.AddOrder(OrderType::GoodTillCancel, 4, Side::Sell, 100, 14);
+	ASSERT_EQ(trades.size(), 2);
+	ASSERT_EQ(trades[0].GetBidTrade().orderId_, 2);
+	ASSERT_EQ(trades[0].GetBidTrade().quantity_, 4);
+	ASSERT_EQ(trades[1].GetBidTrade().orderId_, 3);
+	ASSERT_EQ(trades[1].GetBidTrade().quantity_, 10);
+	ASSERT_EQ(orderbook.Size(), 1);
+}
+
+TEST(OrderbookModifyTests, ReductionKeepsQueuePosition) {
+	RunModifyKeepsPriorityTest<Orderbook>();
+	RunModifyKeepsPriorityTest<LadderOrderbook>();
+}
+
+TEST(LadderOrderbookTests, RejectsBeforeTouchingTheBook) {
+	LadderOrderbook orderbook{ 10 };
+	orderbook.AddOrder(OrderType::GoodTillCancel, 1, Side::Sell, 100, 10);
+	orderbook.AddOrder(OrderType::GoodTillCancel, 2, Side::Buy, 90, 10);
+
+	auto assertUntouched = [&orderbook] {
+		const auto infos = orderbook.GetOrderInfos();
+		ASSERT_EQ(orderbook.Size(), 2);
+		ASSERT_EQ(infos.GetBids().size(), 1);
+		ASSERT_EQ(infos.GetBids()[0].price_, 90);
+		ASSERT_EQ(infos.GetAsks().size(), 1);
+		ASSERT_EQ(infos.GetAsks()[0].quantity_, 10);
+	};
+
+	// Both would cross the resting ask before finding out they cannot rest, off the tick grid or far past the ladder.
+	ASSERT_THROW(orderbook.AddOrder(OrderType::GoodTillCancel, 3, Side::Buy, 105, 20), std::logic_error);
+	assertUntouched();
+	ASSERT_THROW(orderbook.AddOrder(OrderType::GoodTillCancel, 4, Side::Buy, 4'000'000'000, 20), std::logic_error);
+	assertUntouched();
+
+	ASSERT_THROW(orderbook.ModifyOrder(OrderModify{ 2, Side::Buy, 95, 10 }), std::logic_error);
+	assertUntouched();
+	ASSERT_THROW(orderbook.ModifyOrder(OrderModify{ 2, Side::Buy, 4'000'000'000, 10 }), std::logic_error);
+	assertUntouched();
+
+	// A FillAndKill order never rests, so a far limit just sweeps the side.
+	ASSERT_EQ(orderbook.AddOrder(OrderType::FillAndKill, 5, Side::Buy, 4'000'000'000, 4).size(), 1);
+
+	// Far prices that still fit grow the ladder.
+	const Price farPrice = 100 + 10 * static_cast<Price>(LadderOrderbook::MAX_LEVEL_COUNT / 4);
+	ASSERT_TRUE(orderbook.AddOrder(OrderType::GoodTillCancel, 6, Side::Sell, farPrice, 10).empty());
+	ASSERT_EQ(orderbook.GetOrderInfos().GetAsks().back().price_, farPrice);
+	ASSERT_EQ(orderbook.Size(), 3);
+}
+
+TEST(OrderQueueTests, ErasesFromAnyPosition) {
+	std::vector<Order> orders;
+	for (OrderId orderId = 0; orderId < 5; ++orderId)
+		orders.emplace_back(OrderType::GoodTillCancel, orderId, Side::Buy, 100, 1);
+
+	OrderQueue queue;
+	for (auto& order : orders)
+		queue.push_back(order);
+
+	auto ids = [](const OrderQueue& queue) {
+		OrderIds ids;
+		for (const auto& order : queue)
+			ids.push_back(order.GetOrderId());
+		return ids;
+	};
+
+	// Head, middle and tail.
+	queue.erase(orders[0]);
+	queue.erase(orders[2]);
+	queue.erase(orders[4]);
+	ASSERT_EQ(ids(queue), (OrderIds{ 1, 3 }));
+	ASSERT_EQ(queue.size(), 2);
+	ASSERT_EQ(queue.front().GetOrderId(), 1);
+
+	// An erased order is unlinked and can be queued again, at the back.
+	queue.push_back(orders[0]);
+	queue.pop_front();
+	ASSERT_EQ(ids(queue), (OrderIds{ 3, 0 }));
+
+	OrderQueue moved{ std::move(queue) };
+	ASSERT_TRUE(queue.empty());
+	ASSERT_TRUE(queue.begin() == queue.end());
+	ASSERT_EQ(ids(moved), (OrderIds{ 3, 0 }));
+
+	moved.erase(orders[0]);
+	moved.erase(orders[3]);
+	ASSERT_TRUE(moved.empty());
+	ASSERT_TRUE(moved.begin() == moved.end());
+}
+
+TEST(OrderPoolTests, ReusesFreedSlotsAndGrows) {
+	OrderPool pool{ 4 };
+	std::vector<Order*> orders;
+	for (OrderId orderId = 0; orderId < 4; ++orderId)
+		orders.push_back(pool.Acquire(OrderType::GoodTillCancel, orderId, Side::Buy, 100, 1));
+
+	ASSERT_EQ(pool.Size(), 4);
+	ASSERT_EQ(pool.Capacity(), 4);
+
+	// The last released slot is the first one handed out again.
+	Order* released = orders[1];
+	pool.Release(released);
+	orders[1] = pool.Acquire(OrderType::GoodTillCancel, 10, Side::Sell, 200, 2);
+	ASSERT_EQ(orders[1], released);
+	ASSERT_EQ(pool.Capacity(), 4);
+
+	// Growing adds a chunk without moving the orders already handed out.
+	orders.push_back(pool.Acquire(OrderType::GoodTillCancel, 4, Side::Buy, 100, 1));
+	ASSERT_EQ(pool.Size(), 5);
+	ASSERT_EQ(pool.Capacity(), 8);
+	ASSERT_EQ(orders[0]->GetOrderId(), 0);
+	ASSERT_EQ(orders[1]->GetOrderId(), 10);
+	ASSERT_EQ(orders[3]->GetOrderId(), 3);
+
+	pool.Reserve(20);
+	ASSERT_EQ(pool.Capacity(), 20);
+
+	for (Order* order : orders)
+		pool.Release(order);
+	ASSERT_EQ(pool.Size(), 0);
+
+	OrderPool fixed{ 2, false };
+	Order* first = fixed.Acquire(OrderType::GoodTillCancel, 1, Side::Buy, 100, 1);
+	fixed.Acquire(OrderType::GoodTillCancel, 2, Side::Buy, 100, 1);
+	ASSERT_THROW(fixed.Acquire(OrderType::GoodTillCancel, 3, Side::Buy, 100, 1), std::logic_error);
+
+	fixed.Release(first);
+	ASSERT_EQ(fixed.Acquire(OrderType::GoodTillCancel, 3, Side::Buy, 100, 1), first);
+}
+
+template <typename Hash, typename NextKey>
+void RunFlatHashMapTest(NextKey nextKey) {
+	std::mt19937_64 rng(42);
+	FlatHashMap<std::uint64_t, std::uint64_t, Hash> map;
+	std::unordered_map<std::uint64_t, std::uint64_t> reference;
+	std::vector<std::uint64_t> keys;
+
+	for (int i = 0; i < 200'000; ++i) {
+		const auto kind = rng() % 100;
+
+		if (keys.empty() || kind < 45) {
+			const std::uint64_t key = nextKey(rng);
+			const std::uint64_t value = rng();
+			const auto [it, inserted] = map.insert({ key, value });
+
+			ASSERT_EQ(inserted, !reference.contains(key));
+			if (inserted) {
+				reference[key] = value;
+				keys.push_back(key);
+			}
+			ASSERT_EQ(it->second, reference.at(key));
+		} else if (kind < 80) {
+			// Erases go by key and by iterator, each leaving a hole the rest of the cluster shifts back into.
+			const std::size_t slot = rng() % keys.size();
+			const std::uint64_t key = keys[slot];
+			keys[slot] = keys.back();
+			keys.pop_back();
+
+			if (kind % 2)
+				ASSERT_EQ(map.erase(key), 1);
+			else
+				map.erase(map.find(key));
+
+			reference.erase(key);
+			ASSERT_FALSE(map.contains(key));
+			ASSERT_EQ(map.erase(key), 0);
+		} else if (kind < 95) {
+			const std::uint64_t key = rng() % 2 ? keys[rng() % keys.size()] : nextKey(rng);
+			const auto it = map.find(key);
+
+			ASSERT_EQ(it != map.end(), reference.contains(key));
+			if (it != map.end())
+				ASSERT_EQ(it->second, reference.at(key));
+			else
+				ASSERT_THROW(map.at(key), std::out_of_range);
+		} else if (kind < 99) {
+			const std::uint64_t key = keys[rng() % keys.size()];
+			map[key] += 1;
+			reference[key] += 1;
+		} else {
+			map.reserve(map.size() + rng() % 10'000);
+		}
+
+		ASSERT_EQ(map.size(), reference.size());
+	}
+
+	std::size_t visited = 0;
+	for (const auto& [key, value] : map) {
+		ASSERT_EQ(reference.at(key), value);
+		++visited;
+	}
+	ASSERT_EQ(visited, reference.size());
+
+	map.clear();
+	ASSERT_TRUE(map.empty());
+	ASSERT_TRUE(map.begin() == map.end());
+}
+
+// Sends every key to the first slot until the table has 1024 slots, so small tables are one long cluster and a few
+// hundred keys already probe far enough to force a rehash.
+struct CollidingHash {
+	std::size_t operator()(std::uint64_t key, int shift) const {
+		return shift > 54 ? 0 : FibonacciHash{}(key, shift);
+	}
+};
+
+TEST(FlatHashMapTests, MatchesReference) {
+	// Mostly sequential order ids in a few interleaved runs, with jumps and stale ids.
+	RunFlatHashMapTest<SequentialIdHash>([next = std::array<std::uint64_t, 4>{ 0, 1ull << 20, 1ull << 40, 1ull << 60 }](auto& rng) mutable {
+		const auto kind = rng() % 100;
+		auto& run = next[rng() % next.size()];
+		return kind < 90 ? run++ : kind < 95 ? (run += 1'000) : run - rng() % 64;
+	});
+
+	// Prices on a coarse tick.
+	RunFlatHashMapTest<FibonacciHash>([](auto& rng) { return 30'000'000 + rng() % 100'000 * 1'000'000; });
+
+	RunFlatHashMapTest<CollidingHash>([](auto& rng) { return rng() % 400; });
+
+	// 300 keys fit 512 slots by load, but the 256th sits MAX_DISTANCE slots from its home.
+	FlatHashMap<std::uint64_t, std::uint64_t, CollidingHash> colliding;
+	for (std::uint64_t key = 0; key < 300; ++key)
+		ASSERT_TRUE(colliding.insert({ key, key * 2 }).second);
+	for (std::uint64_t key = 0; key < 300; ++key)
+		ASSERT_EQ(colliding.at(key), key * 2);
+	ASSERT_EQ(colliding.size(), 300);
+}
+
+TEST(OrderIdIndexTests, DenseMatchesReference) {
+	std::mt19937_64 rng(42);
+	std::vector<std::unique_ptr<Order>> orders;
+	std::unordered_map<OrderId, Order*> reference;
+	OrderIdIndex index{ OrderIndexMode::Dense };
+	OrderIds live;
+	OrderId nextId = 1;
+
+	for (int i = 0; i < 200'000; ++i) {
+		if (live.empty() || rng() % 2) {
+			// Mostly sequential ids, with jumps past the window and stale ids that land in the hash fallback.
+			const auto kind = rng() % 100;
+			const OrderId orderId = kind < 95 ? nextId++
+				: kind < 98 ? (nextId += OrderIdIndex::PAGE_SIZE * OrderIdIndex::MAX_PAGE_GAP * 2)
+				: rng() % nextId;
+
+			if (reference.contains(orderId))
+				continue;
+
+			orders.push_back(std::make_unique<Order>(OrderType::GoodTillCancel, orderId, Side::Buy, 100, 1));
+			index.Insert(*orders.back());
+			reference[orderId] = orders.back().get();
+			live.push_back(orderId);
+		} else {
+			const std::size_t slot = rng() % live.size();
+			const OrderId orderId = live[slot];
+			live[slot] = live.back();
+			live.pop_back();
+
+			ASSERT_EQ(index.Find(orderId), reference.at(orderId));
+			ASSERT_EQ(index.Erase(orderId), reference.at(orderId));
+			ASSERT_EQ(index.Find(orderId), nullptr);
+			reference.erase(orderId);
+		}
+
+		ASSERT_EQ(index.size(), reference.size());
+	}
+
+	std::size_t visited = 0;
+	index.ForEach([&](const Order& order) {
+		ASSERT_EQ(reference.at(order.GetOrderId()), &order);
+		++visited;
+	});
+	ASSERT_EQ(visited, reference.size());
+}
+
+TEST(OrderFifoTests, MatchesReferenceQueue) {
+	std::mt19937_64 rng(42);
+	std::map<OrderFifo::Sequence, std::pair<OrderId, Quantity>> reference;
+	OrderFifo fifo;
+	OrderId nextId = 1;
+
+	for (int i = 0; i < 200'000; ++i) {
+		const auto kind = rng() % 10;
+
+		if (reference.empty() || kind < 5) {
+			const Quantity quantity = 1 + rng() % 100;
+			const auto sequence = fifo.Push(nextId, quantity);
+
+			ASSERT_FALSE(reference.contains(sequence));
+			reference[sequence] = { nextId++, quantity };
+		} else if (kind < 7) {
+			// Cancels land near the front, so dead slots pile up ahead of live ones.
+			auto it = reference.begin();
+			std::advance(it, rng() % std::min<std::size_t>(reference.size(), 16));
+
+			ASSERT_EQ(fifo.Remove(it->first), it->second.second);
+			reference.erase(it);
+		} else if (kind < 9) {
+			const auto it = reference.begin();
+
+			ASSERT_EQ(fifo.FrontId(), it->second.first);
+			ASSERT_EQ(fifo.FrontRemaining(), it->second.second);
+			fifo.PopFront();
+			reference.erase(it);
+		} else {
+			auto it = reference.begin();
+			std::advance(it, rng() % reference.size());
+
+			ASSERT_EQ(fifo.RemainingAt(it->first), it->second.second);
+		}
+
+		ASSERT_EQ(fifo.Size(), reference.size());
+	}
+}
+
+TEST(SimdKernelsTests, EveryLevelMatchesScalar) {
+	std::mt19937_64 rng(42);
+	const std::array<SimdKernels::Level, 3> levels = { SimdKernels::Level::Scalar, SimdKernels::Level::Avx2, SimdKernels::Level::Avx512 };
+
+	for (std::size_t count = 0; count < 100; ++count) {
+		// Few distinct values so ties are common, half of them above the sign bit so unsigned ordering matters.
+		std::vector<std::uint64_t> values(count);
+		for (auto& value : values)
+			value = (rng() % 2 ? std::uint64_t{ 1 } << 63 : 0) + rng() % 4;
+
+		const auto minIndex = static_cast<std::size_t>(std::min_element(values.begin(), values.end()) - values.begin());
+		const auto maxIndex = static_cast<std::size_t>(std::max_element(values.begin(), values.end()) - values.begin());
+
+		for (const auto level : levels) {
+			ASSERT_EQ(SimdKernels::FindMinPrice(values.data(), count, level), minIndex);
+			ASSERT_EQ(SimdKernels::FindMaxPrice(values.data(), count, level), maxIndex);
+		}
+	}
+}
+
+TEST(LatencyHistogramTests, PercentilesStayWithinPrecision) {
+	std::mt19937_64 rng(42);
+	LatencyHistogram histogram;
+	LatencyHistogram merged;
+	std::vector<std::uint64_t> values;
+
+	for (int i = 0; i < 100'000; ++i) {
+		// Spread over many orders of magnitude, so both the exact and the sub-bucketed ranges are hit.
+		const std::uint64_t value = rng() >> (rng() % 64);
+		values.push_back(value);
+		(i % 2 ? histogram : merged).Record(value);
+	}
+
+	histogram.Merge(merged);
+	std::sort(values.begin(), values.end());
+
+	ASSERT_EQ(histogram.GetCount(), values.size());
+	ASSERT_EQ(histogram.GetMin(), values.front());
+	ASSERT_EQ(histogram.GetMax(), values.back());
+	ASSERT_EQ(histogram.GetValueAtPercentile(1.0), values.back());
+
+	for (const double percentile : { 0.0, 0.1, 0.5, 0.9, 0.99, 0.999 }) {
+		const auto exact = values[std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(percentile * values.size()))) - 1];
+		const auto reported = histogram.GetValueAtPercentile(percentile);
+
+		ASSERT_GE(reported, exact);
+		ASSERT_LE(reported - exact, exact / 64);
+	}
+
+	histogram.Reset();
+	ASSERT_EQ(histogram.GetCount(), 0);
+	ASSERT_EQ(histogram.GetValueAtPercentile(0.5), 0);
+}
+
+TEST(BenchmarkReportTests, ExportsEveryPrintedPercentile) {
+	LatencyHistogram histogram;
+	for (std::uint64_t value = 1; value <= 10'000; ++value)
+		histogram.Record(value);
+
+	BenchmarkReport report;
+	report.Add("Ladder", "add", histogram);
+
+	const std::string values = std::to_string(histogram.GetValueAtPercentile(0.5)) + ',' + std::to_string(histogram.GetValueAtPercentile(0.9)) + ','
+		+ std::to_string(histogram.GetValueAtPercentile(0.99)) + ',' + std::to_string(histogram.GetValueAtPercentile(0.999)) + ','
+		+ std::to_string(histogram.GetMax());
+
+	std::ostringstream csv;
+	report.WriteCsv(csv);
+	ASSERT_EQ(csv.str(), "book,operation,samples,mean_ns,p50_ns,p90_ns,p99_ns,p99.9_ns,max_ns\nLadder,add,10000,5000.5," + values + "\n");
+
+	std::ostringstream json;
+	report.WriteJson(json);
+	for (const auto& [name, percentile] : { std::pair{ "p50", 0.5 }, { "p90", 0.9 }, { "p99", 0.99 }, { "p99.9", 0.999 }, { "max", 1.0 } }) {
+		const auto field = std::format("\"{}_ns\": {}", name, histogram.GetValueAtPercentile(percentile));
+		ASSERT_NE(json.str().find(field), std::string::npos) << field;
+	}
+}
+
+TEST(OrderFlowGeneratorTests, FeedbackKeepsTheFlowOnLiveOrders) {
+	OrderFlowGenerator::Config config;
+	config.minLiveOrders_ = 1'000;
+
+	OrderFlowGenerator generator(config);
+	Orderbook orderbook;
+	LadderOrderbook ladder;
+	std::map<OrderType, std::size_t> types;
+
+	for (int i = 0; i < 100'000; ++i) {
+		const OrderCommand command = generator.Next();
+		const std::size_t size = orderbook.Size();
+
+		const Trades trades = ApplyOrderCommand(orderbook, command);
+		ASSERT_EQ(ApplyOrderCommand(ladder, command).size(), trades.size());
+		generator.OnTrades(trades);
+
+		// With feedback every cancel hits an order that still rests.
+		if (command.type_ == OrderCommandType::Cancel)
+			ASSERT_EQ(orderbook.Size(), size - 1);
+		if (command.type_ == OrderCommandType::Add)
+			++types[command.orderType_];
+	}
+
+	ASSERT_EQ(orderbook.Size(), ladder.Size());
+	ASSERT_EQ(types.size(), 5);
+
+	const auto infos = orderbook.GetOrderInfos();
+	ASSERT_FALSE(infos.GetBids().empty());
+	ASSERT_FALSE(infos.GetAsks().empty());
+	ASSERT_LT(infos.GetBids().front().price_, infos.GetAsks().front().price_);
+}
+
+TEST(OrderFlowGeneratorTests, AddsWhenNothingRests) {
+	// Without a live floor, and with every fill reported, the live set keeps running empty.
+	OrderFlowGenerator::Config config;
+	config.minLiveOrders_ = 0;
+	config.marketShare_ = 0.5;
+
+	OrderFlowGenerator generator(config);
+	LadderOrderbook ladder;
+	std::size_t resting = 0;
+
+	for (int i = 0; i < 10'000; ++i) {
+		const OrderCommand command = generator.Next();
+
+		if (command.type_ != OrderCommandType::Add)
+			ASSERT_GT(resting, 0);
+
+		generator.OnTrades(ApplyOrderCommand(ladder, command));
+		resting = ladder.Size();
+	}
+}
+
+TEST(OrderJournalTests, ReplaysWhatWasJournaled) {
+	OrderFlowGenerator::Config config;
+	config.minLiveOrders_ = 1'000;
+
+	OrderFlowGenerator generator(config);
+	Orderbook orderbook;
+	JournalEntries entries;
+	std::size_t trades = 0;
+
+	for (std::uint64_t i = 0; i < 20'000; ++i) {
+		const OrderCommand command = generator.Next();
+		const Trades executed = ApplyOrderCommand(orderbook, command);
+
+		generator.OnTrades(executed);
+		trades += executed.size();
+		entries.push_back(JournalEntry{ i * 100, command });
+	}
+
+	const auto path = std::filesystem::temp_directory_path() / "OrderJournalTests.journal";
+	{
+		OrderJournalWriter writer(path);
+		for (const auto& entry : entries)
+			writer.Write(entry);
+		writer.Flush();
+	}
+
+	const auto read = OrderJournalReader::ReadAll(path);
+	std::filesystem::remove(path);
+
+	ASSERT_EQ(read.size(), entries.size());
+	for (std::size_t i = 0; i < read.size(); ++i) {
+		ASSERT_EQ(read[i].timestamp_, entries[i].timestamp_);
+		const auto& [type, orderType, side, symbol, orderId, price, quantity] = read[i].command_;
+		const auto& expected = entries[i].command_;
+
+		ASSERT_TRUE(type == expected.type_ && orderType == expected.orderType_ && side == expected.side_);
+		ASSERT_TRUE(symbol == expected.symbol_ && orderId == expected.orderId_ && price == expected.price_ && quantity == expected.quantity_);
+	}
+
+	LadderOrderbook replayed;
+	const auto result = ReplayJournal(replayed, read, ReplayPace::MaxSpeed);
+
+	ASSERT_EQ(result.commands_, entries.size());
+	ASSERT_EQ(result.trades_, trades);
+	ASSERT_EQ(result.latencies_.GetCount(), entries.size());
+	ASSERT_EQ(replayed.Size(), orderbook.Size());
+}
+
+TEST(MatchingEngineTests, ShardsMatchOneBookPerSymbol) {
+	constexpr SymbolId SYMBOL_COUNT = 16;
+	constexpr std::size_t PRODUCER_COUNT = 4;
+	constexpr std::size_t COMMANDS_PER_SYMBOL = 2'000;
+
+	// Every symbol gets its own flow, with the trades it causes in a book of its own as the reference.
+	std::vector<std::vector<OrderCommand>> flows(SYMBOL_COUNT);
+	std::size_t expectedTrades = 0;
+
+	for (SymbolId symbol = 0; symbol < SYMBOL_COUNT; ++symbol) {
+		OrderFlowGenerator::Config config;
+		config.seed_ = symbol;
+		config.symbol_ = symbol;
+		config.minLiveOrders_ = 100;
+
+		OrderFlowGenerator generator(config);
+		UnsyncOrderbook reference;
+
+		for (std::size_t i = 0; i < COMMANDS_PER_SYMBOL; ++i) {
+			flows[symbol].push_back(generator.Next());
+			const Trades trades = ApplyOrderCommand(reference, flows[symbol].back());
+			generator.OnTrades(trades);
+			expectedTrades += trades.size();
+		}
+	}
+
+	MatchingEngine engine{ 4 };
+	ASSERT_EQ(engine.GetShardCount(), 4);
+
+	// Each producer owns a few symbols spread over every shard and submits them interleaved, one at a time or in
+	// batches, so every symbol's commands reach its shard in order.
+	std::vector<std::thread> producers;
+	for (std::size_t producer = 0; producer < PRODUCER_COUNT; ++producer) {
+		producers.emplace_back([&, producer] {
+			std::vector<OrderCommand> batch;
+
+			for (std::size_t i = 0; i < COMMANDS_PER_SYMBOL; ++i) {
+				const bool batched = i / 100 % 2 == 1;
+
+				if (!batched && !batch.empty()) {
+					engine.Submit(batch);
+					batch.clear();
+				}
+
+				for (SymbolId symbol = 0; symbol < SYMBOL_COUNT; ++symbol) {
+					if (symbol / PRODUCER_COUNT % PRODUCER_COUNT != producer) continue;
+
+					if (batched)
+						batch.push_back(flows[symbol][i]);
+					else
+						engine.Submit(flows[symbol][i]);
+				}
+			}
+
+			engine.Submit(batch);
+		});
+	}
+
+	for (auto& producer : producers)
+		producer.join();
+
+	engine.Stop();
+
+	ASSERT_EQ(engine.GetProcessedCount(), SYMBOL_COUNT * COMMANDS_PER_SYMBOL);
+	ASSERT_EQ(engine.GetTradeCount(), expectedTrades);
+	ASSERT_THROW(engine.Submit(flows[0][0]), std::logic_error);
+	ASSERT_THROW(engine.Submit(flows[0]), std::logic_error);
+	ASSERT_NO_THROW(engine.Stop());
+
+	ASSERT_EQ(MatchingEngine{ 0 }.GetShardCount(), 1);
+}
+
+TEST(MatchingEngineTests, StopReportsAFailedShard) {
+	const OrderCommand add{ OrderCommandType::Add, OrderType::GoodTillCancel, Side::Buy, 0, 1, 100, 10 };
+	OrderCommand invalid = add;
+	invalid.type_ = static_cast<OrderCommandType>(0xff);
+	invalid.symbol_ = 1;
+
+	{
+		MatchingEngine engine{ 2 };
+		engine.Submit(add);
+		engine.Submit(invalid);
+
+		// The other shard keeps going and drains its queue.
+		ASSERT_THROW(engine.Stop(), std::logic_error);
+		ASSERT_EQ(engine.GetProcessedCount(), 1);
+	}
+
+	// Destroying an engine with a failed shard without stopping it first must not terminate.
+	MatchingEngine engine{ 2 };
+	engine.Submit(invalid);
+}
+
+template <typename Queue>
+void RunRingBufferSingleThreadTest() {
+	Queue queue{ 5 };
+	ASSERT_EQ(queue.Capacity(), 8);
+
+	std::array<std::uint64_t, 8> output;
+	ASSERT_EQ(queue.PopBatch(output.data(), output.size()), 0);
+
+	std::uint64_t pushed = 0;
+	std::uint64_t popped = 0;
+
+	// Uneven pushes and pops walk the indices around the buffer many times over.
+	for (std::size_t round = 0; round < 1'000; ++round) {
+		while (queue.TryPush(pushed))
+			++pushed;
+
+		ASSERT_EQ(pushed - popped, queue.Capacity());
+
+		// The single-producer queue may hand out fewer values than are queued while its cached tail still has some.
+		const std::size_t count = queue.PopBatch(output.data(), 1 + round % 7);
+		ASSERT_GE(count, 1);
+		ASSERT_LE(count, 1 + round % 7);
+
+		for (std::size_t i = 0; i < count; ++i)
+			ASSERT_EQ(output[i], popped++);
+	}
+
+	// Batches larger than what is queued drain it and then come back empty.
+	while (popped != pushed) {
+		const std::size_t count = queue.PopBatch(output.data(), output.size());
+		ASSERT_GE(count, 1);
+
+		for (std::size_t i = 0; i < count; ++i)
+			ASSERT_EQ(output[i], popped++);
+	}
+	ASSERT_EQ(queue.PopBatch(output.data(), output.size()), 0);
+}
+
+TEST(RingBufferTests, WrapsAroundAndFillsUp) {
+	RunRingBufferSingleThreadTest<SpscRingBuffer<std::uint64_t>>();
+	RunRingBufferSingleThreadTest<MpscRingBuffer<std::uint64_t>>();
+}
+
+template <typename Queue>
+void RunRingBufferProducersTest(std::size_t producerCount) {
+	constexpr std::uint64_t VALUES_PER_PRODUCER = 50'000;
+
+	// Small enough that producers keep finding it full.
+	Queue queue{ 64 };
+	std::vector<std::thread> producers;
+
+	for (std::uint64_t producer = 0; producer < producerCount; ++producer) {
+		producers.emplace_back([&queue, producer] {
+			for (std::uint64_t i = 0; i < VALUES_PER_PRODUCER; ++i) {
+				while (!queue.TryPush(producer << 32 | i))
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	// Every producer's values must arrive exactly once and in the order it pushed them.
+	std::vector<std::uint64_t> next(producerCount, 0);
+	std::array<std::uint64_t, 32> output;
+
+	for (std::uint64_t received = 0; received < producerCount * VALUES_PER_PRODUCER;) {
+		const std::size_t count = queue.PopBatch(output.data(), output.size());
+		if (count == 0)
+			std::this_thread::yield();
+
+		for (std::size_t i = 0; i < count; ++i) {
+			const std::uint64_t producer = output[i] >> 32;
+			ASSERT_LT(producer, producerCount);
+			ASSERT_EQ(output[i] & 0xffff'ffff, next[producer]++);
+		}
+
+		received += count;
+	}
+
+	for (auto& producer : producers)
+		producer.join();
+
+	ASSERT_EQ(queue.PopBatch(output.data(), output.size()), 0);
+}
+
+TEST(RingBufferTests, NothingLostOrDuplicatedAcrossThreads) {
+	RunRingBufferProducersTest<SpscRingBuffer<std::uint64_t>>(1);
+	RunRingBufferProducersTest<MpscRingBuffer<std::uint64_t>>(4);
+}
+
+template <typename Gateway>
+void RunGatewayDrainTest(std::size_t producerCount) {
+	constexpr OrderId ORDERS_PER_PRODUCER = 20'000;
+
+	// Producers own disjoint id ranges and only rest orders on their own side of 1000, so none of them ever trade.
+	std::atomic<std::size_t> handled{ 0 };
+	Gateway gateway{ 64, [&handled](const OrderCommand&, const Trades&) { handled.fetch_add(1, std::memory_order_relaxed); } };
+	std::vector<std::thread> producers;
+
+	for (std::size_t producer = 0; producer < producerCount; ++producer) {
+		producers.emplace_back([&gateway, producer] {
+			const Side side = producer % 2 ? Side::Sell : Side::Buy;
+			const Price price = side == Side::Buy ? 900 : 1'100;
+
+			for (OrderId i = 0; i < ORDERS_PER_PRODUCER; ++i) {
+				const OrderId orderId = producer * ORDERS_PER_PRODUCER + i;
+				gateway.Submit(OrderCommand{ OrderCommandType::Add, OrderType::GoodTillCancel, side, 0, orderId, price, 1 });
+			}
+		});
+	}
+
+	for (auto& producer : producers)
+		producer.join();
+
+	// Stop must drain whatever is still queued before the matching thread exits.
+	gateway.Stop();
+
+	ASSERT_EQ(gateway.GetProcessedCount(), producerCount * ORDERS_PER_PRODUCER);
+	ASSERT_EQ(handled.load(), producerCount * ORDERS_PER_PRODUCER);
+	ASSERT_EQ(gateway.GetTradeCount(), 0);
+	ASSERT_THROW(gateway.TrySubmit(OrderCommand{}), std::logic_error);
+}
+
+TEST(OrderGatewayTests, StopDrainsEverySubmittedCommand) {
+	RunGatewayDrainTest<SpscOrderGateway>(1);
+	RunGatewayDrainTest<OrderGateway>(4);
+}
+
+TEST(WorkStealingDequeTests, EveryValueIsTakenOrStolenOnce) {
+	constexpr std::uint64_t VALUE_COUNT = 200'000;
+	constexpr std::size_t STEALER_COUNT = 3;
+
+	// Starts tiny so the buffer grows while thieves are reading it.
+	WorkStealingDeque<std::uint64_t> deque{ 2 };
+	std::vector<std::atomic<std::uint32_t>> seen(VALUE_COUNT);
+	std::atomic<bool> done{ false };
+
+	std::vector<std::thread> stealers;
+	for (std::size_t i = 0; i < STEALER_COUNT; ++i) {
+		stealers.emplace_back([&] {
+			while (true) {
+				if (const auto value = deque.Steal()) {
+					seen[*value].fetch_add(1, std::memory_order_relaxed);
+				} else if (done.load(std::memory_order_acquire)) {
+					return;
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	// The owner pushes in bursts and takes back every third value, so the last element is often contended.
+	for (std::uint64_t value = 0; value < VALUE_COUNT; ++value) {
+		deque.Push(value);
+
+		if (value % 3 == 0) {
+			if (const auto taken = deque.Take())
+				seen[*taken].fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	while (const auto taken = deque.Take())
+		seen[*taken].fetch_add(1, std::memory_order_relaxed);
+
+	done.store(true, std::memory_order_release);
+	for (auto& stealer : stealers)
+		stealer.join();
+
+	ASSERT_TRUE(deque.Empty());
+	for (std::uint64_t value = 0; value < VALUE_COUNT; ++value)
+		ASSERT_EQ(seen[value].load(), 1) << "value " << value;
+}
+
+TEST(WorkStealingThreadPoolTests, RunsEveryTaskOnce) {
+	WorkStealingThreadPool pool{ 4 };
+	ASSERT_EQ(pool.size(), 4);
+
+	// Tasks submitted from inside the pool land on the worker's own deque and get stolen from there.
+	auto nested = pool.submit([&pool] {
+		std::vector<std::future<int>> inner;
+		for (int i = 0; i < 100; ++i)
+			inner.push_back(pool.submit([](int value) { return value * 2; }, i));
+
+		int sum = 0;
+		for (auto& future : inner)
+			sum += future.get();
+		return sum;
+	});
+	ASSERT_EQ(nested.get(), 9'900);
+
+	constexpr std::size_t BULK_COUNT = 10'000;
+	std::vector<std::atomic<std::uint32_t>> runs(BULK_COUNT);
+	pool.submit_bulk(BULK_COUNT, [&runs](std::size_t i) { runs[i].fetch_add(1, std::memory_order_relaxed); }).get();
+	for (const auto& run : runs)
+		ASSERT_EQ(run.load(), 1);
+
+	ASSERT_NO_THROW(pool.submit_bulk(0, [](std::size_t) {}).get());
+
+	// Every task still runs when one of them throws, and the first exception reaches the future.
+	std::atomic<std::size_t> ran{ 0 };
+	auto failing = pool.submit_bulk(100, [&ran](std::size_t i) {
+		ran.fetch_add(1, std::memory_order_relaxed);
+		if (i == 42)
+			throw std::runtime_error("task failed");
+	});
+	ASSERT_THROW(failing.get(), std::runtime_error);
+	ASSERT_EQ(ran.load(), 100);
+}
+
+TEST(WorkStealingThreadPoolTests, ParallelForCoversTheRangeOnce) {
+	WorkStealingThreadPool pool{ 4 };
+
+	// Sizes below, at and above the chunk count, and one that does not split evenly.
+	for (const std::size_t size : { 0, 1, 3, 16, 17, 1'001 }) {
+		std::vector<std::size_t> values(size);
+		std::iota(values.begin(), values.end(), 0);
+		std::vector<std::atomic<std::uint32_t>> visits(size);
+
+		pool.parallel_for(values.begin(), values.end(), [&visits](auto first, auto last, std::size_t offset) {
+			for (auto it = first; it != last; ++it, ++offset) {
+				ASSERT_EQ(*it, offset);
+				visits[*it].fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+
+		for (const auto& visit : visits)
+			ASSERT_EQ(visit.load(), 1);
+	}
+
+	// Works on iterators that are not random access.
+	std::list<int> list(50, 1);
+	std::atomic<int> sum{ 0 };
+	pool.parallel_for(list.begin(), list.end(), [&sum](auto first, auto last, std::size_t) {
+		sum.fetch_add(std::accumulate(first, last, 0), std::memory_order_relaxed);
+	});
+	ASSERT_EQ(sum.load(), 50);
+}
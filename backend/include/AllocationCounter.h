@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+/* Counts calls to the global operator new, so benchmarks can report how many heap allocations an operation costs.
+ * Counting replaces the global operator new and delete of the whole binary, so AllocationCounter.cpp only does so when
+ * COUNT_ALLOCATIONS is defined, which only the benchmark project does. Anywhere else the default allocator stays and
+ * GetCount always returns zero. Each thread counts into its own counter and GetCount sums them, so the engine, gateway
+ * and pool threads don't all bump one shared cache line on every allocation.
+ */
+struct AllocationCounter {
+	static std::size_t GetCount();
+};
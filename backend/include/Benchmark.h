@@ -5,11 +5,26 @@
 #include <string>
 #include <iostream>
 #include <random>
+#include <numeric>
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <unordered_map>
+#include <array>
 
 #include "Orderbook.h"
+#include "AllocationCounter.h"
+#include "PerfCounters.h"
+#include "OrderCommand.h"
+#include "LatencyHistogram.h"
+#include "BenchmarkReport.h"
+#include "OrderFlowGenerator.h"
 
 using std::chrono::high_resolution_clock;
+using std::chrono::steady_clock;
 using std::chrono::milliseconds;
+using std::chrono::microseconds;
+using std::chrono::nanoseconds;
 
 namespace {
 	constexpr OrderId INITIAL_ORDER_ID = 1;
@@ -20,6 +35,28 @@ namespace {
 	constexpr uint64_t QTY_MAX = 1000;
 	constexpr double BUY_PROBABILITY = 0.5;
 	constexpr double MS_TO_SEC = 1000.0;
+	constexpr size_t DEPTH_BENCHMARK_ITERATIONS = 100'000;
+	constexpr size_t LOCK_BENCHMARK_REPETITIONS = 5;
+	constexpr size_t GATEWAY_BURST_SIZE = 64;
+	constexpr uint64_t FOK_LEVEL_REACH = 10;
+	constexpr size_t FOK_ROUND_SIZE = 10'000;
+	constexpr double MARKET_ORDER_PROBABILITY = 0.5;
+	constexpr double REDUCE_PROBABILITY = 0.5;
+	constexpr size_t INDEX_RECENT_WINDOW = 10'000;
+	constexpr double INDEX_RECENT_PROBABILITY = 0.9;
+	constexpr size_t CACHE_MISS_SNAPSHOTS = 100;
+	constexpr size_t LATENCY_SNAPSHOTS = 100;
+	constexpr size_t LATENCY_ORDERS_PER_LEVEL = 10;
+}
+
+template <typename T>
+inline volatile T benchmarkSink{};
+
+/* Stores the value into a volatile sink, so the work that produced it can't be optimized away.
+ */
+template <typename T>
+void doNotOptimize(const T& value) {
+	benchmarkSink<T> = value;
 }
 
 template <typename OrderbookType>
@@ -37,12 +74,41 @@ void prepareOrderbookBenchmark(size_t numOrders, OrderbookType& orderbook) {
 		uint64_t qty = qtyDist(rng);
 
 		//std::cout << "Adding order id " << orderId << " " << (side == Side::Buy ? "buy" : "sell") << " " << price << " " << qty << '\n';
-		auto order = std::make_shared<Order>(OrderType::GoodTillCancel, orderId++, side, price, qty);
-		
-		orderbook.AddOrder(order);
+		orderbook.AddOrder(OrderType::GoodTillCancel, orderId++, side, price, qty);
+	}
+}
+
+/* Fills the book with the given amount of orders spread evenly over price levels holding ordersPerLevel orders each.
+ * Bids take the lower half of the levels and asks the upper half, so nothing crosses.
+ */
+template <typename OrderbookType>
+void prepareLevelsBenchmark(size_t numOrders, size_t ordersPerLevel, OrderbookType& orderbook) {
+	OrderId orderId = INITIAL_ORDER_ID;
+	const size_t levelsPerSide = std::max<size_t>(1, numOrders / ordersPerLevel / 2);
+
+	std::mt19937 rng(RNG_SEED);
+	std::uniform_int_distribution<uint64_t> qtyDist(QTY_MIN, QTY_MAX);
+
+	for (size_t level = 0; level < levelsPerSide; ++level) {
+		for (size_t i = 0; i < ordersPerLevel; ++i) {
+			orderbook.AddOrder(OrderType::GoodTillCancel, orderId++, Side::Buy, PRICE_MIN + level, qtyDist(rng));
+			orderbook.AddOrder(OrderType::GoodTillCancel, orderId++, Side::Sell, PRICE_MIN + levelsPerSide + level, qtyDist(rng));
+		}
 	}
 }
 
+template<typename OrderbookType, typename Func>
+void runSnapshotBenchmark(const std::string& label, const OrderbookType& orderbook, Func&& getLevelInfosFn) {
+	auto start = high_resolution_clock::now();
+
+	OrderbookLevelInfos levelInfos = getLevelInfosFn(orderbook);
+
+	auto end = high_resolution_clock::now();
+	auto duration = duration_cast<microseconds>(end - start).count();
+
+	std::cout << "Executed " << label << " over " << levelInfos.GetBids().size() + levelInfos.GetAsks().size() << " levels in " << duration << "us\n";
+}
+
 template<typename OrderbookType, typename Func>
 void runBenchmark(const std::string& label, size_t numOrders, Func&& getLevelInfosFn) {
 	OrderbookType orderbook;
@@ -59,17 +125,756 @@ void runBenchmark(const std::string& label, size_t numOrders, Func&& getLevelInf
 	std::cout << "Levels: " << levelInfos.GetBids().size() + levelInfos.GetAsks().size() << "\n";
 }
 
+template<typename OrderbookType, typename Func>
+void runDepthBenchmark(const std::string& label, size_t numOrders, size_t depth, Func&& getDepthInfosFn) {
+	OrderbookType orderbook;
+	prepareOrderbookBenchmark(numOrders, orderbook);
+
+	OrderbookDepthInfos depthInfos;
+
+	auto start = high_resolution_clock::now();
+
+	for (size_t i = 0; i < DEPTH_BENCHMARK_ITERATIONS; ++i)
+		getDepthInfosFn(orderbook, depth, depthInfos);
+
+	auto end = high_resolution_clock::now();
+	auto duration = duration_cast<nanoseconds>(end - start).count() / DEPTH_BENCHMARK_ITERATIONS;
+
+	std::cout << "Executed " << label << " at depth " << depth << " of an orderbook with " << numOrders << " elements in " << duration << "ns per snapshot\n";
+	std::cout << "Levels: " << depthInfos.GetBids().size() + depthInfos.GetAsks().size() << "\n";
+}
+
 template <typename OrderbookType>
-void runAddOrderBenchmark(size_t numOrders) {
+void runAddOrderBenchmark(const std::string& label, size_t numOrders) {
 	OrderbookType orderbook;
+	const auto allocationsBefore = AllocationCounter::GetCount();
 	auto start = high_resolution_clock::now();
 	prepareOrderbookBenchmark<OrderbookType>(numOrders, orderbook);
 
 	auto end = high_resolution_clock::now();
-	auto duration = duration_cast<milliseconds>(end - start).count();
+	auto duration = std::max<long long>(1, duration_cast<milliseconds>(end - start).count());
+	const auto allocations = AllocationCounter::GetCount() - allocationsBefore;
+
+	std::cout << "Processed " << label << " of " << numOrders << " orders in " << duration << "ms\n";
+	std::cout << "Throughput: " << (numOrders * MS_TO_SEC / duration) << " orders/sec\n";
+	std::cout << "Allocations: " << allocations << " (" << static_cast<double>(allocations) / numOrders << " per order)\n";
+}
+
+/* Sends FillOrKill orders against a book of single-order price levels. Each order reaches up to FOK_LEVEL_REACH levels
+ * past the current best opposite price with a quantity that may or may not fit, so both the accept and reject paths are hit.
+ * Accepted orders eat into the book, so it is rebuilt (untimed) every FOK_ROUND_SIZE orders.
+ */
+template <typename OrderbookType>
+void runFillOrKillBenchmark(const std::string& label, size_t numLevels, size_t numOrders) {
+	std::mt19937 rng(RNG_SEED);
+	std::uniform_int_distribution<uint64_t> reachDist(0, FOK_LEVEL_REACH);
+	std::uniform_int_distribution<uint64_t> qtyDist(QTY_MIN, QTY_MAX * FOK_LEVEL_REACH);
+	std::bernoulli_distribution sideDist(BUY_PROBABILITY);
+
+	OrderbookDepthInfos best;
+	size_t filled = 0;
+	nanoseconds duration{};
+
+	for (size_t round = 0; round < numOrders; round += FOK_ROUND_SIZE) {
+		OrderbookType orderbook;
+		prepareLevelsBenchmark(numLevels, 1, orderbook);
+
+		OrderId orderId = INITIAL_ORDER_ID + numLevels;
+		auto start = high_resolution_clock::now();
+
+		for (size_t i = round; i < std::min(numOrders, round + FOK_ROUND_SIZE); ++i) {
+			orderbook.GetOrderInfos(1, best);
+			if (best.GetBids().empty() || best.GetAsks().empty())
+				break;
+
+			const Side side = sideDist(rng) ? Side::Buy : Side::Sell;
+			const Price price = side == Side::Buy ? best.GetAsks()[0].price_ + reachDist(rng) : best.GetBids()[0].price_ - reachDist(rng);
+
+			if (!orderbook.AddOrder(OrderType::FillOrKill, orderId++, side, price, qtyDist(rng)).empty())
+				++filled;
+		}
+
+		duration += duration_cast<nanoseconds>(high_resolution_clock::now() - start);
+	}
+
+	const auto durationMs = std::max<long long>(1, duration_cast<milliseconds>(duration).count());
+
+	std::cout << "Processed " << label << " of " << numOrders << " FillOrKill orders against " << numLevels << " levels in " << durationMs << "ms ("
+		<< filled << " filled)\n";
+	std::cout << "Throughput: " << (numOrders * MS_TO_SEC / durationMs) << " orders/sec\n";
+}
+
+/* Runs a market-order-heavy flow against a book prepared with prepareLevelsBenchmark. Every other order on average
+ * is a market order sweeping the opposite side; the rest are passive GoodTillCancel orders placed back inside the
+ * prepared price range of their own side, so they replenish liquidity without ever crossing.
+ */
+template <typename OrderbookType>
+void runMarketOrderBenchmark(const std::string& label, size_t numRestingOrders, size_t ordersPerLevel, size_t numOrders) {
+	OrderbookType orderbook;
+	prepareLevelsBenchmark(numRestingOrders, ordersPerLevel, orderbook);
+
+	const size_t levelsPerSide = std::max<size_t>(1, numRestingOrders / ordersPerLevel / 2);
+
+	std::mt19937 rng(RNG_SEED);
+	std::uniform_int_distribution<uint64_t> levelDist(0, levelsPerSide - 1);
+	std::uniform_int_distribution<uint64_t> qtyDist(QTY_MIN, QTY_MAX);
+	std::bernoulli_distribution sideDist(BUY_PROBABILITY);
+	std::bernoulli_distribution marketDist(MARKET_ORDER_PROBABILITY);
+
+	OrderId orderId = INITIAL_ORDER_ID + numRestingOrders;
+	size_t trades = 0;
+
+	auto start = high_resolution_clock::now();
+
+	for (size_t i = 0; i < numOrders; ++i) {
+		const Side side = sideDist(rng) ? Side::Buy : Side::Sell;
+
+		if (marketDist(rng)) {
+			trades += orderbook.AddOrder(OrderType::Market, orderId++, side, Constants::InvalidPrice, qtyDist(rng)).size();
+		} else {
+			const Price price = side == Side::Buy ? PRICE_MIN + levelDist(rng) : PRICE_MIN + levelsPerSide + levelDist(rng);
+			orderbook.AddOrder(OrderType::GoodTillCancel, orderId++, side, price, qtyDist(rng));
+		}
+	}
+
+	auto end = high_resolution_clock::now();
+	auto duration = std::max<long long>(1, duration_cast<milliseconds>(end - start).count());
+
+	std::cout << "Processed " << label << " of " << numOrders << " market-heavy orders in " << duration << "ms (" << trades << " trades)\n";
+	std::cout << "Throughput: " << (numOrders * MS_TO_SEC / duration) << " orders/sec\n";
+}
+
+/* Counts hardware cache misses while a book prepared with prepareLevelsBenchmark runs the market-heavy flow of
+ * runMarketOrderBenchmark, and then while it takes full snapshots. The flow is generated up front, so only the book's
+ * own memory traffic is counted. Reports misses per order and per snapshot, or a notice if counters are unavailable.
+ */
+template <typename OrderbookType>
+void runCacheMissBenchmark(const std::string& label, size_t numRestingOrders, size_t ordersPerLevel, size_t numOrders) {
+	PerfCounters counters;
+	if (!counters.IsAvailable()) {
+		std::cout << "Skipped " << label << " cache misses: " << counters.GetUnavailableReason() << "\n";
+		return;
+	}
+
+	OrderbookType orderbook;
+	prepareLevelsBenchmark(numRestingOrders, ordersPerLevel, orderbook);
+
+	const size_t levelsPerSide = std::max<size_t>(1, numRestingOrders / ordersPerLevel / 2);
+
+	std::mt19937 rng(RNG_SEED);
+	std::uniform_int_distribution<uint64_t> levelDist(0, levelsPerSide - 1);
+	std::uniform_int_distribution<uint64_t> qtyDist(QTY_MIN, QTY_MAX);
+	std::bernoulli_distribution sideDist(BUY_PROBABILITY);
+	std::bernoulli_distribution marketDist(MARKET_ORDER_PROBABILITY);
+
+	std::vector<OrderCommand> orders;
+	orders.reserve(numOrders);
+
+	for (OrderId orderId = INITIAL_ORDER_ID + numRestingOrders; orders.size() < numOrders; ++orderId) {
+		const Side side = sideDist(rng) ? Side::Buy : Side::Sell;
+
+		if (marketDist(rng)) {
+			orders.push_back(OrderCommand{ OrderCommandType::Add, OrderType::Market, side, 0, orderId, Constants::InvalidPrice, qtyDist(rng) });
+		} else {
+			const Price price = side == Side::Buy ? PRICE_MIN + levelDist(rng) : PRICE_MIN + levelsPerSide + levelDist(rng);
+			orders.push_back(OrderCommand{ OrderCommandType::Add, OrderType::GoodTillCancel, side, 0, orderId, price, qtyDist(rng) });
+		}
+	}
+
+	counters.Start();
+	for (const auto& order : orders)
+		orderbook.AddOrder(order.orderType_, order.orderId_, order.side_, order.price_, order.quantity_);
+	const auto flow = counters.Stop();
+
+	size_t levels = 0;
+
+	counters.Start();
+	for (size_t i = 0; i < CACHE_MISS_SNAPSHOTS; ++i)
+		levels += orderbook.GetOrderInfos().GetBids().size();
+	const auto snapshots = counters.Stop();
+
+	auto ratio = [](uint64_t count, size_t per) { return static_cast<double>(count) / std::max<size_t>(1, per); };
+
+	std::cout << "Measured " << label << " over " << numOrders << " market-heavy orders: " << ratio(flow.cacheMisses_, numOrders)
+		<< " cache misses and " << ratio(flow.instructions_, numOrders) << " instructions per order ("
+		<< ratio(flow.cacheMisses_ * 100, flow.cacheReferences_) << "% of cache references)\n";
+	std::cout << "Measured " << label << " over " << CACHE_MISS_SNAPSHOTS << " snapshots of " << levels / CACHE_MISS_SNAPSHOTS
+		<< " bid levels: " << ratio(snapshots.cacheMisses_, CACHE_MISS_SNAPSHOTS) << " cache misses per snapshot\n";
+}
+
+/* Fills a book with random non-crossing orders, bids below the middle of the price range and asks above it, and then
+ * modifies every order once in random order. Half of the modifies on average reduce the quantity at the same price,
+ * which the books apply in place; the rest move the order to a new random price on its own side.
+ */
+template <typename OrderbookType>
+void runModifyOrderBenchmark(const std::string& label, size_t numOrders) {
+	constexpr uint64_t PRICE_MID = PRICE_MIN + (PRICE_MAX - PRICE_MIN) / 2;
+
+	std::mt19937 rng(RNG_SEED);
+	std::uniform_int_distribution<uint64_t> bidPriceDist(PRICE_MIN, PRICE_MID);
+	std::uniform_int_distribution<uint64_t> askPriceDist(PRICE_MID + 1, PRICE_MAX);
+	std::uniform_int_distribution<uint64_t> qtyDist(QTY_MIN, QTY_MAX);
+	std::bernoulli_distribution sideDist(BUY_PROBABILITY);
+	std::bernoulli_distribution reduceDist(REDUCE_PROBABILITY);
+
+	OrderbookType orderbook;
+	std::vector<OrderModify> modifies;
+	modifies.reserve(numOrders);
+
+	for (OrderId orderId = INITIAL_ORDER_ID; orderId < INITIAL_ORDER_ID + numOrders; ++orderId) {
+		const Side side = sideDist(rng) ? Side::Buy : Side::Sell;
+		auto& priceDist = side == Side::Buy ? bidPriceDist : askPriceDist;
+		const Price price = priceDist(rng);
+		const Quantity quantity = qtyDist(rng);
+
+		orderbook.AddOrder(OrderType::GoodTillCancel, orderId, side, price, quantity);
+
+		if (reduceDist(rng))
+			modifies.emplace_back(orderId, side, price, std::max<Quantity>(QTY_MIN, quantity / 2));
+		else
+			modifies.emplace_back(orderId, side, priceDist(rng), quantity);
+	}
+
+	std::shuffle(modifies.begin(), modifies.end(), rng);
+
+	auto start = high_resolution_clock::now();
+
+	for (const auto& modify : modifies)
+		orderbook.ModifyOrder(modify);
+
+	auto end = high_resolution_clock::now();
+	auto duration = std::max<long long>(1, duration_cast<milliseconds>(end - start).count());
 
-	std::cout << "Processed " << numOrders << " orders in " << duration << "ms\n";
+	std::cout << "Processed " << label << " of " << numOrders << " orders in " << duration << "ms\n";
 	std::cout << "Throughput: " << (numOrders * MS_TO_SEC / duration) << " orders/sec\n";
 }
 
-void runAllBenchmarks(ThreadPool& pool);
+template <typename OrderbookType>
+void runCancelOrderBenchmark(const std::string& label, size_t numOrders) {
+	OrderbookType orderbook;
+	prepareOrderbookBenchmark<OrderbookType>(numOrders, orderbook);
+
+	// Cancel in random order so the benchmark doesn't just walk the book front to back.
+	OrderIds orderIds(numOrders);
+	std::iota(orderIds.begin(), orderIds.end(), INITIAL_ORDER_ID);
+	std::shuffle(orderIds.begin(), orderIds.end(), std::mt19937(RNG_SEED));
+
+	auto start = high_resolution_clock::now();
+
+	for (const auto& orderId : orderIds)
+		orderbook.CancelOrder(orderId);
+
+	auto end = high_resolution_clock::now();
+	auto duration = std::max<long long>(1, duration_cast<milliseconds>(end - start).count());
+
+	std::cout << "Processed " << label << " of " << numOrders << " orders in " << duration << "ms\n";
+	std::cout << "Throughput: " << (numOrders * MS_TO_SEC / duration) << " orders/sec\n";
+}
+
+/* Times one add, one Size() query and one cancel per order against a fresh book and returns the average ns per operation.
+ */
+template <typename OrderbookType>
+double timeOrderLifecycle(size_t numOrders) {
+	OrderbookType orderbook;
+	OrderIds orderIds(numOrders);
+	std::iota(orderIds.begin(), orderIds.end(), INITIAL_ORDER_ID);
+	std::shuffle(orderIds.begin(), orderIds.end(), std::mt19937(RNG_SEED));
+
+	// Summed and sunk after the loop so the Size() calls aren't optimized away, without a volatile store per order.
+	size_t sizes = 0;
+	auto start = high_resolution_clock::now();
+
+	prepareOrderbookBenchmark<OrderbookType>(numOrders, orderbook);
+
+	for (const auto& orderId : orderIds) {
+		sizes += orderbook.Size();
+		orderbook.CancelOrder(orderId);
+	}
+
+	auto end = high_resolution_clock::now();
+	doNotOptimize(sizes);
+
+	return static_cast<double>(duration_cast<nanoseconds>(end - start).count()) / (numOrders * 3);
+}
+
+/* Runs the same add/size/cancel workload on a locking and a lock-free book and reports the uncontended lock overhead per operation.
+ */
+template <typename LockedType, typename UnlockedType>
+void runLockOverheadBenchmark(const std::string& label, size_t numOrders) {
+	// Interleave the runs and keep the fastest of each, so warmup and noise don't end up in the difference.
+	double locked = std::numeric_limits<double>::max();
+	double unlocked = std::numeric_limits<double>::max();
+
+	for (size_t i = 0; i < LOCK_BENCHMARK_REPETITIONS; ++i) {
+		locked = std::min(locked, timeOrderLifecycle<LockedType>(numOrders));
+		unlocked = std::min(unlocked, timeOrderLifecycle<UnlockedType>(numOrders));
+	}
+
+	std::cout << "Processed " << label << " lifecycle of " << numOrders << " orders in " << locked << "ns per operation with locks and "
+		<< unlocked << "ns without\n";
+	std::cout << "Uncontended lock overhead: " << locked - unlocked << "ns per operation\n";
+}
+
+/* Adds random GoodTillCancel orders and then cancels all of them in shuffled order, once one call per order and once
+ * in batches of the given size, and reports the time per order of each.
+ */
+template <typename OrderbookType>
+void runBatchBenchmark(const std::string& label, size_t numOrders, size_t batchSize) {
+	std::mt19937 rng(RNG_SEED);
+	std::uniform_int_distribution<uint64_t> priceDist(PRICE_MIN, PRICE_MAX);
+	std::uniform_int_distribution<uint64_t> qtyDist(QTY_MIN, QTY_MAX);
+	std::bernoulli_distribution sideDist(BUY_PROBABILITY);
+
+	std::vector<OrderCommand> orders;
+	orders.reserve(numOrders);
+
+	for (OrderId orderId = INITIAL_ORDER_ID; orderId < INITIAL_ORDER_ID + numOrders; ++orderId) {
+		const Side side = sideDist(rng) ? Side::Buy : Side::Sell;
+		orders.push_back(OrderCommand{ OrderCommandType::Add, OrderType::GoodTillCancel, side, 0, orderId, priceDist(rng), qtyDist(rng) });
+	}
+
+	OrderIds orderIds(numOrders);
+	std::iota(orderIds.begin(), orderIds.end(), INITIAL_ORDER_ID);
+	std::shuffle(orderIds.begin(), orderIds.end(), rng);
+
+	auto perOrder = [numOrders](auto duration) { return static_cast<double>(duration_cast<nanoseconds>(duration).count()) / numOrders; };
+
+	double singleAdd = 0;
+	double singleCancel = 0;
+
+	{
+		OrderbookType orderbook;
+
+		auto start = high_resolution_clock::now();
+		for (const auto& order : orders)
+			orderbook.AddOrder(order.orderType_, order.orderId_, order.side_, order.price_, order.quantity_);
+		auto added = high_resolution_clock::now();
+		for (const auto& orderId : orderIds)
+			orderbook.CancelOrder(orderId);
+		auto end = high_resolution_clock::now();
+
+		singleAdd = perOrder(added - start);
+		singleCancel = perOrder(end - added);
+	}
+
+	double batchAdd = 0;
+	double batchCancel = 0;
+
+	{
+		OrderbookType orderbook;
+		const std::span<const OrderCommand> orderSpan{ orders };
+		const std::span<const OrderId> orderIdSpan{ orderIds };
+
+		auto start = high_resolution_clock::now();
+		for (size_t i = 0; i < numOrders; i += batchSize)
+			orderbook.AddOrders(orderSpan.subspan(i, std::min(batchSize, numOrders - i)));
+		auto added = high_resolution_clock::now();
+		for (size_t i = 0; i < numOrders; i += batchSize)
+			orderbook.CancelOrders(orderIdSpan.subspan(i, std::min(batchSize, numOrders - i)));
+		auto end = high_resolution_clock::now();
+
+		batchAdd = perOrder(added - start);
+		batchCancel = perOrder(end - added);
+	}
+
+	std::cout << "Processed " << label << " of " << numOrders << " orders in batches of " << batchSize << ": add " << singleAdd << "ns -> "
+		<< batchAdd << "ns, cancel " << singleCancel << "ns -> " << batchCancel << "ns per order\n";
+}
+
+/* Counts the trades a book reports without storing them, standing in for a consumer that streams them onwards.
+ */
+class CountingExecutionSink final : public IExecutionSink {
+public:
+	void OnTrade(const Trade& trade) override { ++trades_; }
+	size_t GetTradeCount() const { return trades_; }
+
+private:
+	size_t trades_{};
+};
+
+struct TradeReportingResult {
+	double nsPerOrder_;
+	size_t allocations_;
+	size_t trades_;
+};
+
+/* Adds the same random GoodTillCancel flow as prepareOrderbookBenchmark to a fresh book, collecting the trades either
+ * through the Trades-returning AddOrder or through an IExecutionSink.
+ */
+template <typename OrderbookType>
+TradeReportingResult timeTradeReporting(size_t numOrders, bool useSink) {
+	OrderbookType orderbook;
+	CountingExecutionSink sink;
+	size_t trades = 0;
+
+	std::mt19937 rng(RNG_SEED);
+	std::uniform_int_distribution<uint64_t> priceDist(PRICE_MIN, PRICE_MAX);
+	std::uniform_int_distribution<uint64_t> qtyDist(QTY_MIN, QTY_MAX);
+	std::bernoulli_distribution sideDist(BUY_PROBABILITY);
+
+	OrderId orderId = INITIAL_ORDER_ID;
+	const auto allocationsBefore = AllocationCounter::GetCount();
+	auto start = high_resolution_clock::now();
+
+	for (size_t i = 0; i < numOrders; ++i) {
+		const Side side = sideDist(rng) ? Side::Buy : Side::Sell;
+		const Price price = priceDist(rng);
+		const Quantity quantity = qtyDist(rng);
+
+		if (useSink)
+			orderbook.AddOrder(OrderType::GoodTillCancel, orderId++, side, price, quantity, sink);
+		else
+			trades += orderbook.AddOrder(OrderType::GoodTillCancel, orderId++, side, price, quantity).size();
+	}
+
+	auto end = high_resolution_clock::now();
+
+	return {
+		static_cast<double>(duration_cast<nanoseconds>(end - start).count()) / numOrders,
+		AllocationCounter::GetCount() - allocationsBefore,
+		useSink ? sink.GetTradeCount() : trades
+	};
+}
+
+/* Compares reporting trades through the Trades-returning AddOrder against streaming them into an IExecutionSink.
+ */
+template <typename OrderbookType>
+void runTradeReportingBenchmark(const std::string& label, size_t numOrders) {
+	// Interleave the runs and keep the fastest of each, so warmup and noise don't end up in the difference.
+	TradeReportingResult returned{ std::numeric_limits<double>::max() };
+	TradeReportingResult streamed{ std::numeric_limits<double>::max() };
+
+	for (size_t i = 0; i < LOCK_BENCHMARK_REPETITIONS; ++i) {
+		const auto returnedRun = timeTradeReporting<OrderbookType>(numOrders, false);
+		const auto streamedRun = timeTradeReporting<OrderbookType>(numOrders, true);
+
+		if (returnedRun.nsPerOrder_ < returned.nsPerOrder_) returned = returnedRun;
+		if (streamedRun.nsPerOrder_ < streamed.nsPerOrder_) streamed = streamedRun;
+	}
+
+	std::cout << "Processed " << label << " of " << numOrders << " orders (" << returned.trades_ << " trades) in "
+		<< returned.nsPerOrder_ << "ns per order returning Trades and " << streamed.nsPerOrder_ << "ns streaming into a sink\n";
+	std::cout << "Allocations: " << returned.allocations_ << " returning Trades, " << streamed.allocations_ << " streaming into a sink\n";
+}
+
+std::vector<OrderCommand> prepareOrderCommands(size_t numCommands, SymbolId symbolCount);
+void runMatchingEngineBenchmark(size_t numCommands, SymbolId symbolCount, size_t maxShards);
+void printLatencyPercentiles(const LatencyHistogram& latencies);
+void writeBenchmarkReport(const BenchmarkReport& report);
+void runBestPriceScanBenchmark(size_t numOrders);
+
+/* Streams commands through the gateway in bursts of GATEWAY_BURST_SIZE, waiting for each burst to be matched,
+ * and reports the latency from enqueueing an add until the matching thread reports its trades.
+ */
+template <typename GatewayType>
+void runGatewayLatencyBenchmark(const std::string& label, size_t numCommands) {
+	const auto commands = prepareOrderCommands(numCommands, 1);
+
+	std::vector<high_resolution_clock::time_point> enqueued(numCommands + INITIAL_ORDER_ID);
+	LatencyHistogram latencies;
+
+	GatewayType gateway(GatewayType::DEFAULT_CAPACITY, [&](const OrderCommand& command, const Trades& trades) {
+		if (command.type_ == OrderCommandType::Add && !trades.empty())
+			latencies.Record(duration_cast<nanoseconds>(high_resolution_clock::now() - enqueued[command.orderId_]).count());
+	});
+
+	auto start = high_resolution_clock::now();
+
+	for (size_t i = 0; i < commands.size(); ++i) {
+		if (commands[i].type_ == OrderCommandType::Add)
+			enqueued[commands[i].orderId_] = high_resolution_clock::now();
+
+		gateway.Submit(commands[i]);
+
+		if ((i + 1) % GATEWAY_BURST_SIZE == 0) {
+			while (gateway.GetProcessedCount() < i + 1)
+				std::this_thread::yield();
+		}
+	}
+
+	gateway.Stop();
+
+	auto end = high_resolution_clock::now();
+	auto duration = std::max<long long>(1, duration_cast<milliseconds>(end - start).count());
+
+	std::cout << "Processed " << label << " of " << numCommands << " commands in " << duration << "ms (" << gateway.GetTradeCount() << " trades)\n";
+	std::cout << "Throughput: " << (numCommands * MS_TO_SEC / duration) << " commands/sec\n";
+	printLatencyPercentiles(latencies);
+}
+
+/* Fills a book with the given amount of non-crossing resting orders, bids below the middle of the price range and asks
+ * above it, then cancels a random sample of them one at a time and reports the latency percentiles of a single cancel.
+ */
+template <typename OrderbookType, typename... Args>
+void runCancelLatencyBenchmark(const std::string& label, size_t numOrders, size_t numSamples, Args... args) {
+	constexpr uint64_t PRICE_MID = PRICE_MIN + (PRICE_MAX - PRICE_MIN) / 2;
+
+	std::mt19937 rng(RNG_SEED);
+	std::uniform_int_distribution<uint64_t> bidPriceDist(PRICE_MIN, PRICE_MID);
+	std::uniform_int_distribution<uint64_t> askPriceDist(PRICE_MID + 1, PRICE_MAX);
+	std::uniform_int_distribution<uint64_t> qtyDist(QTY_MIN, QTY_MAX);
+	std::bernoulli_distribution sideDist(BUY_PROBABILITY);
+
+	OrderbookType orderbook(numOrders, args...);
+
+	for (OrderId orderId = INITIAL_ORDER_ID; orderId < INITIAL_ORDER_ID + numOrders; ++orderId) {
+		const Side side = sideDist(rng) ? Side::Buy : Side::Sell;
+		const Price price = side == Side::Buy ? bidPriceDist(rng) : askPriceDist(rng);
+		orderbook.AddOrder(OrderType::GoodTillCancel, orderId, side, price, qtyDist(rng));
+	}
+
+	OrderIds orderIds(numOrders);
+	std::iota(orderIds.begin(), orderIds.end(), INITIAL_ORDER_ID);
+	std::shuffle(orderIds.begin(), orderIds.end(), rng);
+	orderIds.resize(std::min(numSamples, numOrders));
+
+	LatencyHistogram latencies;
+
+	for (const auto& orderId : orderIds) {
+		auto start = high_resolution_clock::now();
+		orderbook.CancelOrder(orderId);
+		latencies.Record(duration_cast<nanoseconds>(high_resolution_clock::now() - start).count());
+	}
+
+	std::cout << "Processed " << label << " of " << orderIds.size() << " orders with " << numOrders << " live orders\n";
+	printLatencyPercentiles(latencies);
+}
+
+/* std::unordered_map behind the OrderIdIndex interface, as the baseline for runOrderIndexBenchmark.
+ */
+class UnorderedOrderIndex {
+public:
+	void Insert(Order& order) { orders_.insert({ order.GetOrderId(), &order }); }
+
+	Order* Find(OrderId orderId) const {
+		const auto it = orders_.find(orderId);
+		return it == orders_.end() ? nullptr : it->second;
+	}
+
+	Order* Erase(OrderId orderId) {
+		const auto it = orders_.find(orderId);
+		if (it == orders_.end())
+			return nullptr;
+
+		Order* order = it->second;
+		orders_.erase(it);
+		return order;
+	}
+
+private:
+	std::unordered_map<OrderId, Order*> orders_;
+};
+
+/* Runs a cancel-heavy flow against an order index holding numLive orders with sequential ids: every operation cancels
+ * a live order, mostly one of the last INDEX_RECENT_WINDOW added, and adds the next id. Reports ns per operation.
+ */
+template <typename IndexType>
+void runOrderIndexBenchmark(const std::string& label, IndexType& index, size_t numLive, size_t numOperations) {
+	std::vector<Order> orders;
+	orders.reserve(numLive + numOperations);
+	for (OrderId orderId = INITIAL_ORDER_ID; orderId < INITIAL_ORDER_ID + numLive + numOperations; ++orderId)
+		orders.emplace_back(OrderType::GoodTillCancel, orderId, Side::Buy, PRICE_MIN, QTY_MIN);
+
+	OrderIds live;
+	live.reserve(numLive);
+	for (size_t i = 0; i < numLive; ++i) {
+		index.Insert(orders[i]);
+		live.push_back(orders[i].GetOrderId());
+	}
+
+	std::mt19937 rng(RNG_SEED);
+	std::bernoulli_distribution recentDist(INDEX_RECENT_PROBABILITY);
+	size_t misses = 0;
+
+	auto start = high_resolution_clock::now();
+
+	for (size_t i = 0; i < numOperations; ++i) {
+		const size_t recent = std::min(live.size(), INDEX_RECENT_WINDOW);
+		const size_t slot = recentDist(rng)
+			? live.size() - 1 - std::uniform_int_distribution<size_t>(0, recent - 1)(rng)
+			: std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+
+		if (!index.Find(live[slot]) || !index.Erase(live[slot]))
+			++misses;
+
+		Order& order = orders[numLive + i];
+		index.Insert(order);
+		live[slot] = live.back();
+		live.back() = order.GetOrderId();
+	}
+
+	auto end = high_resolution_clock::now();
+	const double nsPerOperation = static_cast<double>(duration_cast<nanoseconds>(end - start).count()) / numOperations;
+
+	std::cout << "Processed " << label << " of " << numOperations << " cancel/add pairs with " << numLive << " live orders in "
+		<< nsPerOperation << "ns per pair (" << misses << " misses)\n";
+}
+
+/* Runs the given operation and records how long it took, in nanoseconds.
+ */
+template <typename Func>
+void timeOperation(LatencyHistogram& histogram, Func&& operation) {
+	const auto start = steady_clock::now();
+	operation();
+	const auto end = steady_clock::now();
+
+	histogram.Record(static_cast<uint64_t>(duration_cast<nanoseconds>(end - start).count()));
+}
+
+struct LatencySuite {
+	LatencyHistogram add_;
+	LatencyHistogram modify_;
+	LatencyHistogram snapshot_;
+	LatencyHistogram cancel_;
+	LatencyHistogram match_;
+};
+
+/* One round of runLatencySuite against fresh books, drawing every order from the given seed.
+ * A book is filled with numOrders non-crossing orders, every order is modified once as in runModifyOrderBenchmark,
+ * LATENCY_SNAPSHOTS full snapshots are taken and every order is cancelled, each in random order. A second book prepared
+ * with prepareLevelsBenchmark then takes the market-heavy flow of runMarketOrderBenchmark, where only the market
+ * orders are timed.
+ */
+template <typename OrderbookType>
+void runLatencyRound(size_t numOrders, unsigned seed, LatencySuite& suite) {
+	constexpr uint64_t PRICE_MID = PRICE_MIN + (PRICE_MAX - PRICE_MIN) / 2;
+
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<uint64_t> bidPriceDist(PRICE_MIN, PRICE_MID);
+	std::uniform_int_distribution<uint64_t> askPriceDist(PRICE_MID + 1, PRICE_MAX);
+	std::uniform_int_distribution<uint64_t> qtyDist(QTY_MIN, QTY_MAX);
+	std::bernoulli_distribution sideDist(BUY_PROBABILITY);
+	std::bernoulli_distribution reduceDist(REDUCE_PROBABILITY);
+	std::bernoulli_distribution marketDist(MARKET_ORDER_PROBABILITY);
+
+	std::vector<OrderCommand> adds;
+	std::vector<OrderModify> modifies;
+	adds.reserve(numOrders);
+	modifies.reserve(numOrders);
+
+	for (OrderId orderId = INITIAL_ORDER_ID; orderId < INITIAL_ORDER_ID + numOrders; ++orderId) {
+		const Side side = sideDist(rng) ? Side::Buy : Side::Sell;
+		auto& priceDist = side == Side::Buy ? bidPriceDist : askPriceDist;
+		const Price price = priceDist(rng);
+		const Quantity quantity = qtyDist(rng);
+
+		adds.push_back(OrderCommand{ OrderCommandType::Add, OrderType::GoodTillCancel, side, 0, orderId, price, quantity });
+
+		if (reduceDist(rng))
+			modifies.emplace_back(orderId, side, price, std::max<Quantity>(QTY_MIN, quantity / 2));
+		else
+			modifies.emplace_back(orderId, side, priceDist(rng), quantity);
+	}
+
+	std::shuffle(modifies.begin(), modifies.end(), rng);
+
+	OrderIds orderIds(numOrders);
+	std::iota(orderIds.begin(), orderIds.end(), INITIAL_ORDER_ID);
+	std::shuffle(orderIds.begin(), orderIds.end(), rng);
+
+	{
+		OrderbookType orderbook;
+
+		for (const auto& order : adds)
+			timeOperation(suite.add_, [&] { orderbook.AddOrder(order.orderType_, order.orderId_, order.side_, order.price_, order.quantity_); });
+		for (const auto& modify : modifies)
+			timeOperation(suite.modify_, [&] { orderbook.ModifyOrder(modify); });
+		for (size_t i = 0; i < LATENCY_SNAPSHOTS; ++i)
+			timeOperation(suite.snapshot_, [&] { doNotOptimize(orderbook.GetOrderInfos().GetBids().size()); });
+		for (const auto& orderId : orderIds)
+			timeOperation(suite.cancel_, [&] { orderbook.CancelOrder(orderId); });
+	}
+
+	OrderbookType orderbook;
+	prepareLevelsBenchmark(numOrders, LATENCY_ORDERS_PER_LEVEL, orderbook);
+
+	const size_t levelsPerSide = std::max<size_t>(1, numOrders / LATENCY_ORDERS_PER_LEVEL / 2);
+	std::uniform_int_distribution<uint64_t> levelDist(0, levelsPerSide - 1);
+
+	for (OrderId orderId = INITIAL_ORDER_ID + numOrders; orderId < INITIAL_ORDER_ID + 2 * numOrders; ++orderId) {
+		const Side side = sideDist(rng) ? Side::Buy : Side::Sell;
+		const Quantity quantity = qtyDist(rng);
+
+		if (marketDist(rng)) {
+			timeOperation(suite.match_, [&] { orderbook.AddOrder(OrderType::Market, orderId, side, Constants::InvalidPrice, quantity); });
+		} else {
+			const Price price = side == Side::Buy ? PRICE_MIN + levelDist(rng) : PRICE_MIN + levelsPerSide + levelDist(rng);
+			orderbook.AddOrder(OrderType::GoodTillCancel, orderId, side, price, quantity);
+		}
+	}
+}
+
+/* Measures the latency of every single add, modify, snapshot, cancel and market-order match against the given book
+ * type over the given amount of rounds, each on fresh books and with its own seed. An extra first round warms up the
+ * caches, the allocator and the branch predictors and is discarded. Prints the percentiles of each operation and adds
+ * them to the report.
+ */
+template <typename OrderbookType>
+void runLatencySuite(const std::string& label, size_t numOrders, size_t repetitions, BenchmarkReport& report) {
+	LatencySuite warmup;
+	runLatencyRound<OrderbookType>(numOrders, RNG_SEED, warmup);
+
+	LatencySuite suite;
+	for (size_t i = 0; i < repetitions; ++i)
+		runLatencyRound<OrderbookType>(numOrders, RNG_SEED + 1 + static_cast<unsigned>(i), suite);
+
+	const std::array<std::pair<const char*, const LatencyHistogram*>, 5> operations = { {
+		{ "add", &suite.add_ }, { "modify", &suite.modify_ }, { "snapshot", &suite.snapshot_ }, { "cancel", &suite.cancel_ }, { "match", &suite.match_ }
+	} };
+
+	for (const auto& [operation, histogram] : operations) {
+		std::cout << "Measured " << label << " " << operation << " over " << histogram->GetCount() << " operations in " << repetitions
+			<< " rounds of " << numOrders << " orders\n";
+		printLatencyPercentiles(*histogram);
+		report.Add(label, operation, *histogram);
+	}
+}
+
+/* Drives a fresh book with numCommands commands of the OrderFlowGenerator flow, resting around the middle of the price
+ * range with at least minLiveOrders orders. The trades of every command are fed back to the generator, so the flow
+ * is the same for every book that matches correctly. Only applying each command is timed. Prints the realized
+ * command mix and the percentiles per command type, and adds them to the report.
+ */
+template <typename OrderbookType>
+void runOrderFlowBenchmark(const std::string& label, size_t numCommands, size_t minLiveOrders, BenchmarkReport& report) {
+	OrderFlowGenerator::Config config;
+	config.seed_ = RNG_SEED;
+	config.initialMid_ = PRICE_MIN + (PRICE_MAX - PRICE_MIN) / 2;
+	config.minLiveOrders_ = minLiveOrders;
+
+	OrderFlowGenerator generator(config);
+	OrderbookType orderbook;
+	Trades executed;
+	// Indexed by OrderCommandType.
+	std::array<LatencyHistogram, 3> latencies;
+	size_t trades = 0;
+
+	for (size_t i = 0; i < numCommands; ++i) {
+		const OrderCommand command = generator.Next();
+
+		timeOperation(latencies[static_cast<size_t>(command.type_)], [&] { executed = ApplyOrderCommand(orderbook, command); });
+
+		generator.OnTrades(executed);
+		trades += executed.size();
+	}
+
+	auto share = [numCommands](const LatencyHistogram& histogram) { return 100.0 * histogram.GetCount() / std::max<size_t>(1, numCommands); };
+
+	std::cout << "Processed " << label << " of " << numCommands << " generated commands (" << share(latencies[0]) << "% adds, "
+		<< share(latencies[1]) << "% cancels, " << share(latencies[2]) << "% modifies) with " << trades << " trades and "
+		<< orderbook.Size() << " resting orders left\n";
+
+	const std::array<std::pair<const char*, OrderCommandType>, 3> operations = { {
+		{ "flow add", OrderCommandType::Add }, { "flow cancel", OrderCommandType::Cancel }, { "flow modify", OrderCommandType::Modify }
+	} };
+
+	for (const auto& [operation, type] : operations) {
+		const auto& histogram = latencies[static_cast<size_t>(type)];
+
+		std::cout << "Measured " << label << " " << operation << " over " << histogram.GetCount() << " operations\n";
+		printLatencyPercentiles(histogram);
+		report.Add(label, operation, histogram);
+	}
+}
+
+void runAllBenchmarks(ThreadPool& pool, WorkStealingThreadPool& stealingPool);
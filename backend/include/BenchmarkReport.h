@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.h"
+
+/* Collects the latency percentiles of every measured book and operation, so a whole benchmark run can be written out
+ * as CSV or JSON and compared between builds or machines.
+ */
+class BenchmarkReport {
+public:
+	void Add(const std::string& book, const std::string& operation, const LatencyHistogram& histogram);
+
+	void WriteCsv(std::ostream& out) const;
+	void WriteJson(std::ostream& out) const;
+
+private:
+	struct Row {
+		std::string book_;
+		std::string operation_;
+		std::uint64_t count_;
+		double mean_;
+		std::uint64_t p50_;
+		std::uint64_t p90_;
+		std::uint64_t p99_;
+		std::uint64_t p999_;
+		std::uint64_t max_;
+	};
+
+	std::vector<Row> rows_;
+};
@@ -1,19 +1,23 @@
 #pragma once
 
-#include <map>
+#include <memory>
 #include <unordered_map>
-#include <thread>
-#include <condition_variable>
-#include <mutex>
+#include <vector>
 #include <stdexcept>
 
 #include "Usings.h"
 #include "Order.h"
 #include "OrderModify.h"
 #include "OrderbookLevelInfos.h"
+#include "OrderbookDepthInfos.h"
 #include "Trade.h"
 #include "IOrderbook.h"
 
+/* Orderbook that keeps each side in a single vector sorted by price and then by time, with the best order at the back.
+ * Inserting finds its slot with a binary search, and matching pops the best order off the back in O(1).
+ * Cancelling only zeroes the order where it stands; such dead orders are dropped once they reach the back,
+ * and a side is compacted as a whole once it holds more dead orders than live ones.
+ */
 class BinarySearchOrderbook : IOrderbook {
 public:
     BinarySearchOrderbook() = default;
@@ -24,31 +28,34 @@ public:
     ~BinarySearchOrderbook() = default;
 
     Trades AddOrder(OrderPointer order) override;
+    Trades AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity) override;
     void CancelOrder(OrderId orderId) override;
     Trades ModifyOrder(OrderModify order) override;
 
     std::size_t Size() const override;
     OrderbookLevelInfos GetOrderInfos() const;
+    void GetOrderInfos(std::size_t depth, OrderbookDepthInfos& infos) const;
 
 private:
-    std::vector<OrderPointer> askOrders_;
-    std::vector<OrderPointer> bidOrders_;
+    struct BookSide {
+        // Asks by descending and bids by ascending price, so the best price sits at the back. Within a price the
+        // oldest order is the furthest back. The side owns its orders, cancelled ones included, until they are dropped.
+        std::vector<std::unique_ptr<Order>> orders_;
+        std::size_t deadCount_{};
+    };
 
-    const OrderPointer getBestAsk() const;
-    const OrderPointer getBestBid() const;
-    const OrderPointer getWorstAsk() const;
-    const OrderPointer getWorstBid() const;
-    bool orderExists(OrderId orderId) const;
+    BookSide asks_;
+    BookSide bids_;
+    std::unordered_map<OrderId, Order*> orders_;
 
-    void CancelOrders(OrderIds orderIds);
-    void CancelOrderInternal(OrderId orderId);
+    BookSide& GetSide(Side side) { return side == Side::Buy ? bids_ : asks_; }
+    const BookSide& GetSide(Side side) const { return side == Side::Buy ? bids_ : asks_; }
 
-    void OnOrderCancelled(OrderPointer order);
-    void OnOrderAdded(OrderPointer order);
-    void OnOrderMatched(Price price, Quantity quantity, bool isFullyFilled);
-    void UpdateLevelData(Price price, Quantity quantity, LevelData::Action action);
+    void InsertOrder(std::unique_ptr<Order> order);
+    void DropDeadBack(BookSide& side);
+    void Compact(BookSide& side);
 
     bool CanFullyFill(Side side, Price price, Quantity quantity) const;
     bool CanMatch(Side side, Price price) const;
-    Trades MatchOrders();
+    Trades MatchOrder(Order& order);
 };
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <limits>
 
 #include "Usings.h"
 
 struct Constants {
 	static const Price InvalidPrice = std::numeric_limits<Price>::quiet_NaN();
+	// Fixed rather than std::hardware_destructive_interference_size, which varies between compilers and flags.
+	static constexpr std::size_t CacheLineSize = 64;
 };
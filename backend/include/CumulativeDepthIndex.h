@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+#include "Usings.h"
+#include "Side.h"
+
+/* Fenwick trees of resting quantity over a price ladder, one per side.
+ * Answers "how much sits between the best price and P" and "how far does a given quantity reach" in O(log L).
+ * The ladder's tick is the gcd of all price distances seen so far, so scaled prices don't blow up the ladder.
+ * Prices outside the current window, or off the current tick, rebuild the trees around the occupied span.
+ * The ladder never grows past MAX_LEVEL_COUNT levels. Once the occupied span no longer fits, the index releases its
+ * trees and goes inactive: it ignores further updates and must not be queried, so its owner answers from its own
+ * levels instead until it replaces the index with a fresh one.
+ */
+class CumulativeDepthIndex {
+public:
+    static constexpr std::size_t DEFAULT_LEVEL_COUNT = 1 << 10;
+    static constexpr std::size_t MAX_LEVEL_COUNT = 1 << 20;
+
+    explicit CumulativeDepthIndex(std::size_t levelCount = DEFAULT_LEVEL_COUNT)
+        : bids_{ std::bit_ceil(std::clamp<std::size_t>(levelCount, 2, MAX_LEVEL_COUNT)) }
+        , asks_{ std::bit_ceil(std::clamp<std::size_t>(levelCount, 2, MAX_LEVEL_COUNT)) }
+    {}
+
+    bool IsActive() const { return active_; }
+
+    /* Runs in amortized O(log L) where L is the amount of ladder levels.
+     */
+    void Add(Side side, Price price, Quantity quantity) {
+        if (!active_) return;
+
+        EnsureInWindow(price);
+
+        if (active_)
+            GetTree(side).Add(ToIndex(price), quantity);
+    }
+
+    /* Removes quantity that was added at the given price before.
+     * Runs in O(log L) where L is the amount of ladder levels.
+     */
+    void Remove(Side side, Price price, Quantity quantity) {
+        if (active_)
+            GetTree(side).Subtract(ToIndex(price), quantity);
+    }
+
+    Quantity GetTotal(Side side) const { return GetTree(side).GetTotal(); }
+
+    /* Returns the quantity resting on the given side at the given price or better, i.e. bids at or above it and asks at or below it.
+     * Runs in O(log L) where L is the amount of ladder levels.
+     */
+    Quantity QuantityUpTo(Side side, Price price) const {
+        const Tree& tree = GetTree(side);
+
+        if (side == Side::Sell)
+            return tree.Prefix(CountAtOrBelow(price));
+
+        return tree.GetTotal() - tree.Prefix(CountBelow(price));
+    }
+
+    /* Returns the worst price on the given side that has to be reached to gather the given (positive) quantity,
+     * or nothing if the side holds less than that.
+     * Runs in O(log L) where L is the amount of ladder levels.
+     */
+    std::optional<Price> PriceForQuantity(Side side, Quantity quantity) const {
+        const Tree& tree = GetTree(side);
+
+        if (quantity == 0 || quantity > tree.GetTotal())
+            return std::nullopt;
+
+        if (side == Side::Sell)
+            return ToPrice(tree.LowerBound(quantity));
+
+        // The best bids sit at the top of the ladder, so look for the last level whose suffix still holds the quantity.
+        return ToPrice(tree.LowerBound(tree.GetTotal() - quantity + 1));
+    }
+
+private:
+    static constexpr std::size_t HEADROOM_FACTOR = 2;
+
+    class Tree {
+    public:
+        explicit Tree(std::size_t size) : nodes_(size + 1) {}
+
+        std::size_t GetSize() const { return nodes_.size() - 1; }
+        Quantity GetTotal() const { return total_; }
+
+        void Add(std::size_t index, Quantity quantity) {
+            total_ += quantity;
+            for (auto i = index + 1; i < nodes_.size(); i += i & (~i + 1))
+                nodes_[i] += quantity;
+        }
+
+        void Subtract(std::size_t index, Quantity quantity) {
+            total_ -= quantity;
+            for (auto i = index + 1; i < nodes_.size(); i += i & (~i + 1))
+                nodes_[i] -= quantity;
+        }
+
+        /* Returns the sum of the first count levels.
+         */
+        Quantity Prefix(std::size_t count) const {
+            Quantity sum = 0;
+            for (auto i = count; i > 0; i -= i & (~i + 1))
+                sum += nodes_[i];
+            return sum;
+        }
+
+        /* Returns the first level at which the running sum reaches the given target, which must be in [1, total].
+         */
+        std::size_t LowerBound(Quantity target) const {
+            std::size_t position = 0;
+
+            for (auto step = std::bit_floor(GetSize()); step > 0; step >>= 1) {
+                if (position + step < nodes_.size() && nodes_[position + step] < target) {
+                    position += step;
+                    target -= nodes_[position];
+                }
+            }
+
+            return position;
+        }
+
+        /* Returns the quantity of every level.
+         */
+        std::vector<Quantity> GetLevels() const {
+            std::vector<Quantity> levels = nodes_;
+            for (auto i = GetSize(); i > 0; --i) {
+                const auto parent = i + (i & (~i + 1));
+                if (parent < levels.size())
+                    levels[parent] -= levels[i];
+            }
+            levels.erase(levels.begin());
+            return levels;
+        }
+
+        /* Rebuilds the tree from the quantity of every level.
+         * Runs in O(L) where L is the amount of levels.
+         */
+        void Assign(const std::vector<Quantity>& levels) {
+            nodes_.assign(levels.size() + 1, 0);
+            total_ = 0;
+
+            for (std::size_t i = 0; i < levels.size(); ++i) {
+                nodes_[i + 1] += levels[i];
+                total_ += levels[i];
+
+                const auto parent = (i + 1) + ((i + 1) & (~(i + 1) + 1));
+                if (parent < nodes_.size())
+                    nodes_[parent] += nodes_[i + 1];
+            }
+        }
+
+    private:
+        std::vector<Quantity> nodes_;
+        Quantity total_{};
+    };
+
+    Tree bids_;
+    Tree asks_;
+    Price base_{};
+    Price anchor_{};
+    Price tick_{};
+    bool initialized_{ false };
+    bool active_{ true };
+
+    Tree& GetTree(Side side) { return side == Side::Buy ? bids_ : asks_; }
+    const Tree& GetTree(Side side) const { return side == Side::Buy ? bids_ : asks_; }
+
+    // Until two distinct prices were seen there is no tick yet, and the only occupied level is the base.
+    Price GetStep() const { return tick_ ? tick_ : 1; }
+    std::size_t ToIndex(Price price) const { return static_cast<std::size_t>((price - base_) / GetStep()); }
+    Price ToPrice(std::size_t index) const { return base_ + static_cast<Price>(index) * GetStep(); }
+    bool InWindow(Price price) const { return price >= base_ && ToIndex(price) < bids_.GetSize(); }
+
+    /* Returns the amount of ladder levels priced at or below the given price.
+     */
+    std::size_t CountAtOrBelow(Price price) const {
+        if (!initialized_ || price < base_) return 0;
+        return std::min(bids_.GetSize(), ToIndex(price) + 1);
+    }
+
+    /* Returns the amount of ladder levels priced strictly below the given price.
+     */
+    std::size_t CountBelow(Price price) const {
+        if (!initialized_ || price <= base_) return 0;
+        return std::min(bids_.GetSize(), ToIndex(price - 1) + 1);
+    }
+
+    void EnsureInWindow(Price price) {
+        if (!initialized_) {
+            base_ = anchor_ = price;
+            initialized_ = true;
+            return;
+        }
+
+        const Price distance = price > anchor_ ? price - anchor_ : anchor_ - price;
+        const Price tick = std::gcd(tick_, distance);
+
+        if (tick != tick_ || !InWindow(price))
+            Rebuild(tick, price);
+    }
+
+    /* Moves every occupied level onto a ladder with the given tick, centred on the occupied span and the given price,
+     * doubling the amount of levels until the span fits with headroom on both sides. Goes inactive instead when that
+     * would take more than MAX_LEVEL_COUNT levels.
+     * Runs in O(L) where L is the amount of ladder levels.
+     */
+    void Rebuild(Price tick, Price price) {
+        const auto bidLevels = bids_.GetLevels();
+        const auto askLevels = asks_.GetLevels();
+
+        Price low = price;
+        Price high = price;
+
+        for (std::size_t i = 0; i < bidLevels.size(); ++i) {
+            if (bidLevels[i] == 0 && askLevels[i] == 0) continue;
+
+            low = std::min(low, ToPrice(i));
+            high = std::max(high, ToPrice(i));
+        }
+
+        const Price step = tick ? tick : 1;
+        const Price span = (high - low) / step + 1;
+
+        if (span > MAX_LEVEL_COUNT / HEADROOM_FACTOR) {
+            active_ = false;
+            bids_ = Tree{ 0 };
+            asks_ = Tree{ 0 };
+            return;
+        }
+
+        std::size_t levelCount = bids_.GetSize();
+        while (levelCount < span * HEADROOM_FACTOR)
+            levelCount *= 2;
+
+        const Price mid = low + (high - low) / (2 * step) * step;
+        const Price offset = static_cast<Price>(levelCount / 2) * step;
+        const Price base = mid > offset ? mid - offset : mid % step;
+
+        std::vector<Quantity> bids(levelCount);
+        std::vector<Quantity> asks(levelCount);
+
+        for (std::size_t i = 0; i < bidLevels.size(); ++i) {
+            if (bidLevels[i] == 0 && askLevels[i] == 0) continue;
+
+            const auto index = static_cast<std::size_t>((ToPrice(i) - base) / step);
+            bids[index] = bidLevels[i];
+            asks[index] = askLevels[i];
+        }
+
+        base_ = base;
+        tick_ = tick;
+        bids_.Assign(bids);
+        asks_.Assign(asks);
+    }
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Usings.h"
+#include "Side.h"
+#include "Trade.h"
+
+/* Receives the events a book produces while it processes an operation, as they happen.
+ * Callbacks run on the thread that mutates the book with its lock held, so they must be short and must not call
+ * back into the book. Every callback defaults to a no-op, so a sink only overrides the events it cares about.
+ */
+class IExecutionSink {
+public:
+	virtual ~IExecutionSink() = default;
+
+	virtual void OnTrade(const Trade& trade) {}
+	virtual void OnOrderAccepted(OrderId orderId, Side side, Price price, Quantity quantity) {}
+	virtual void OnOrderCancelled(OrderId orderId, Quantity remainingQuantity) {}
+	virtual void OnLevelChanged(Side side, Price price, Quantity quantity) {}
+};
+
+/* Sink that drops every event, for operations whose caller doesn't listen.
+ */
+class NullExecutionSink final : public IExecutionSink {};
+
+/* Sink that appends every trade to a caller-owned buffer, backing the Trades-returning API.
+ */
+class TradesExecutionSink final : public IExecutionSink {
+public:
+	explicit TradesExecutionSink(Trades& trades) : trades_{ trades } {}
+
+	void OnTrade(const Trade& trade) override { trades_.push_back(trade); }
+
+private:
+	Trades& trades_;
+};
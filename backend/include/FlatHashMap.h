@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/* Fibonacci hashing for 64-bit integer keys. Consecutive order ids land in well spread slots,
+ * and the high bits it keeps mix in every bit of the key, so strided prices spread just as well.
+ */
+struct FibonacciHash {
+    std::size_t operator()(std::uint64_t key, int shift) const {
+        return static_cast<std::size_t>((key * 11400714819323198485ull) >> shift);
+    }
+};
+
+/* Fibonacci hashing over blocks of eight consecutive keys, with each key placed at its offset inside the block.
+ * Venues hand out order ids sequentially, and the id checked or inserted next then lands right after the previous one
+ * instead of on a cold cache line. Any key set still spreads like FibonacciHash, since at most eight keys share a block.
+ */
+struct SequentialIdHash {
+    std::size_t operator()(std::uint64_t key, int shift) const {
+        const std::size_t mask = (std::size_t{ 1 } << (64 - shift)) - 1;
+        return (FibonacciHash{}(key >> 3, shift) + static_cast<std::size_t>(key & 7)) & mask;
+    }
+};
+
+/* Open-addressing hash map with Robin Hood probing, for integer keys such as order ids and prices.
+ * Entries live inline in a single power of two sized array, so a lookup is a short linear scan with no pointer chasing,
+ * and an insert only allocates when the table grows. Erase shifts the following entries back instead of leaving
+ * tombstones, so probe lengths stay short under heavy churn.
+ * Any insert or erase invalidates iterators and references to entries.
+ */
+template <typename Key, typename Value, typename Hash = FibonacciHash>
+class FlatHashMap {
+    struct Slot {
+        std::pair<Key, Value> entry_{};
+        // Distance from the home slot plus one, zero for empty slots.
+        std::uint8_t distance_{};
+    };
+
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<Key, Value>;
+
+    template <bool IsConst>
+    class Iterator {
+        using SlotPointer = std::conditional_t<IsConst, const Slot*, Slot*>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iterator() = default;
+        Iterator(SlotPointer slot, SlotPointer end) : slot_{ slot }, end_{ end } { SkipEmpty(); }
+        operator Iterator<true>() const { return Iterator<true>{ slot_, end_ }; }
+
+        reference operator*() const { return slot_->entry_; }
+        pointer operator->() const { return &slot_->entry_; }
+
+        Iterator& operator++() {
+            ++slot_;
+            SkipEmpty();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const { return slot_ == other.slot_; }
+
+    private:
+        friend class FlatHashMap;
+
+        SlotPointer slot_{ nullptr };
+        SlotPointer end_{ nullptr };
+
+        void SkipEmpty() {
+            while (slot_ != end_ && slot_->distance_ == 0)
+                ++slot_;
+        }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatHashMap() { Rehash(MIN_CAPACITY); }
+    explicit FlatHashMap(std::size_t capacity) { Rehash(CapacityFor(capacity)); }
+
+    iterator begin() { return { slots_.data(), slots_.data() + slots_.size() }; }
+    iterator end() { return { slots_.data() + slots_.size(), slots_.data() + slots_.size() }; }
+    const_iterator begin() const { return { slots_.data(), slots_.data() + slots_.size() }; }
+    const_iterator end() const { return { slots_.data() + slots_.size(), slots_.data() + slots_.size() }; }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /* Makes room for the given amount of entries, so inserting up to that many never rehashes.
+     * Runs in O(C) where C is the new capacity.
+     */
+    void reserve(std::size_t count) {
+        const auto capacity = CapacityFor(count);
+        if (capacity > slots_.size())
+            Rehash(capacity);
+    }
+
+    void clear() {
+        std::fill(slots_.begin(), slots_.end(), Slot{});
+        size_ = 0;
+    }
+
+    /* Runs in expected O(1).
+     */
+    iterator find(const Key& key) {
+        const auto index = FindIndex(key);
+        return index == npos ? end() : iterator{ slots_.data() + index, slots_.data() + slots_.size() };
+    }
+
+    const_iterator find(const Key& key) const {
+        const auto index = FindIndex(key);
+        return index == npos ? end() : const_iterator{ slots_.data() + index, slots_.data() + slots_.size() };
+    }
+
+    bool contains(const Key& key) const { return FindIndex(key) != npos; }
+
+    Value& at(const Key& key) {
+        const auto index = FindIndex(key);
+        if (index == npos)
+            throw std::out_of_range("FlatHashMap::at");
+
+        return slots_[index].entry_.second;
+    }
+
+    const Value& at(const Key& key) const {
+        const auto index = FindIndex(key);
+        if (index == npos)
+            throw std::out_of_range("FlatHashMap::at");
+
+        return slots_[index].entry_.second;
+    }
+
+    Value& operator[](const Key& key) {
+        return insert({ key, Value{} }).first->second;
+    }
+
+    /* Inserts the entry unless its key is already present, and returns the entry for that key.
+     * Runs in expected O(1), amortized over the occasional rehash.
+     */
+    std::pair<iterator, bool> insert(const value_type& value) {
+        if (const auto index = FindIndex(value.first); index != npos)
+            return { iterator{ slots_.data() + index, slots_.data() + slots_.size() }, false };
+
+        if ((size_ + 1) * MAX_LOAD_DENOMINATOR > slots_.size() * MAX_LOAD_NUMERATOR)
+            Rehash(slots_.size() * 2);
+
+        const auto index = Place(value);
+        ++size_;
+
+        return { iterator{ slots_.data() + index, slots_.data() + slots_.size() }, true };
+    }
+
+    /* Runs in expected O(1).
+     */
+    std::size_t erase(const Key& key) {
+        const auto index = FindIndex(key);
+        if (index == npos)
+            return 0;
+
+        EraseIndex(index);
+        return 1;
+    }
+
+    void erase(const_iterator it) {
+        EraseIndex(static_cast<std::size_t>(it.slot_ - slots_.data()));
+    }
+
+private:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    static constexpr std::size_t MIN_CAPACITY = 16;
+    static constexpr std::size_t MAX_LOAD_NUMERATOR = 7;
+    static constexpr std::size_t MAX_LOAD_DENOMINATOR = 8;
+    static constexpr std::uint8_t MAX_DISTANCE = 255;
+
+    std::vector<Slot> slots_;
+    std::size_t size_{};
+    std::size_t mask_{};
+    int shift_{};
+    Hash hash_;
+
+    static std::size_t CapacityFor(std::size_t count) {
+        return std::bit_ceil(std::max(MIN_CAPACITY, count * MAX_LOAD_DENOMINATOR / MAX_LOAD_NUMERATOR + 1));
+    }
+
+    std::size_t HomeOf(const Key& key) const { return hash_(static_cast<std::uint64_t>(key), shift_); }
+
+    std::size_t FindIndex(const Key& key) const {
+        auto index = HomeOf(key);
+
+        // Robin Hood keeps every probe sequence sorted by distance, so the scan stops at the first entry closer to home.
+        for (std::uint8_t distance = 1; ; ++distance, index = (index + 1) & mask_) {
+            const Slot& slot = slots_[index];
+
+            if (slot.distance_ < distance)
+                return npos;
+
+            if (slot.entry_.first == key)
+                return index;
+        }
+    }
+
+    /* Places an entry whose key is known to be absent, displacing entries that sit closer to their home slot.
+     * Returns the slot the given entry ended up in.
+     */
+    std::size_t Place(value_type value) {
+        const Key key = value.first;
+        auto index = HomeOf(key);
+        std::uint8_t distance = 1;
+        std::size_t placed = npos;
+
+        while (true) {
+            // Probes this long only happen with a pathological key set. Spreading the table out fixes them; the entry
+            // still being carried is placed again afterwards, everything already in the table moves with the rehash.
+            if (distance == MAX_DISTANCE) {
+                Rehash(slots_.size() * 2);
+                Place(std::move(value));
+                return FindIndex(key);
+            }
+
+            Slot& slot = slots_[index];
+
+            if (slot.distance_ == 0) {
+                slot.entry_ = std::move(value);
+                slot.distance_ = distance;
+                return placed == npos ? index : placed;
+            }
+
+            if (slot.distance_ < distance) {
+                std::swap(slot.entry_, value);
+                std::swap(slot.distance_, distance);
+
+                if (placed == npos)
+                    placed = index;
+            }
+
+            ++distance;
+            index = (index + 1) & mask_;
+        }
+    }
+
+    /* Empties the slot at the given index and shifts the rest of its cluster back by one, so no tombstone is left.
+     */
+    void EraseIndex(std::size_t index) {
+        auto next = (index + 1) & mask_;
+
+        while (slots_[next].distance_ > 1) {
+            slots_[index].entry_ = std::move(slots_[next].entry_);
+            slots_[index].distance_ = slots_[next].distance_ - 1;
+
+            index = next;
+            next = (next + 1) & mask_;
+        }
+
+        slots_[index] = Slot{};
+        --size_;
+    }
+
+    void Rehash(std::size_t capacity) {
+        std::vector<Slot> previous = std::exchange(slots_, std::vector<Slot>(capacity));
+
+        mask_ = capacity - 1;
+        shift_ = 64 - std::countr_zero(capacity);
+        size_ = 0;
+
+        for (auto& slot : previous) {
+            if (slot.distance_ == 0)
+                continue;
+
+            Place(std::move(slot.entry_));
+            ++size_;
+        }
+    }
+};
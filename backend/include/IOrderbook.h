@@ -1,20 +1,24 @@
 #pragma once
 
 #include "Order.h"
+#include "OrderQueue.h"
 #include "OrderModify.h"
 #include "Trade.h"
 #include "Usings.h"
+#include "FlatHashMap.h"
 
 #include <map>
 
-using BidMap = std::map<Price, OrderPointers, std::greater<Price>>;
-using AskMap = std::map<Price, OrderPointers, std::less<Price>>;
+using BidMap = std::map<Price, OrderQueue, std::greater<Price>>;
+using AskMap = std::map<Price, OrderQueue, std::less<Price>>;
+using LevelDataMap = FlatHashMap<Price, LevelData>;
 
 class IOrderbook {
 public:
 	virtual ~IOrderbook() = default;
 
 	virtual Trades AddOrder(OrderPointer order) = 0;
+	virtual Trades AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity) = 0;
 	virtual void CancelOrder(OrderId orderId) = 0;
 	virtual Trades ModifyOrder(OrderModify order) = 0;
 
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <stdexcept>
+
+#include "Usings.h"
+#include "Order.h"
+#include "OrderFifo.h"
+#include "FlatHashMap.h"
+#include "OrderModify.h"
+#include "OrderbookLevelInfos.h"
+#include "OrderbookDepthInfos.h"
+#include "Trade.h"
+#include "PriceBitmap.h"
+#include "IOrderbook.h"
+
+/* Orderbook that stores its price levels in a contiguous array indexed by (price - base) / tick.
+ * Best bid/ask are tracked through occupancy bitmaps, and the ladder is recentred (and grown if needed)
+ * whenever an order arrives outside of the current price window. The ladder never grows past MAX_LEVEL_COUNT levels,
+ * so an order that would rest off the tick grid or too far from the rest of the book is rejected before it matches.
+ * Each level keeps its queue as parallel arrays of ids and remaining quantities, and a resting order is only a small
+ * record in a flat map pointing at its slot, so no order lives on the heap on its own.
+ */
+class LadderOrderbook : IOrderbook {
+public:
+    static constexpr Price DEFAULT_TICK_SIZE = 1;
+    static constexpr std::size_t DEFAULT_LEVEL_COUNT = 1 << 16;
+    static constexpr std::size_t MAX_LEVEL_COUNT = 1 << 22;
+
+    LadderOrderbook() : LadderOrderbook(DEFAULT_TICK_SIZE) {}
+    explicit LadderOrderbook(Price tickSize, std::size_t levelCount = DEFAULT_LEVEL_COUNT);
+    LadderOrderbook(const LadderOrderbook&) = delete;
+    void operator=(const LadderOrderbook&) = delete;
+    LadderOrderbook(LadderOrderbook&&) = delete;
+    void operator=(LadderOrderbook&&) = delete;
+    ~LadderOrderbook() = default;
+
+    Trades AddOrder(OrderPointer order) override;
+    Trades AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity) override;
+    void CancelOrder(OrderId orderId) override;
+    Trades ModifyOrder(OrderModify order) override;
+
+    std::size_t Size() const override;
+    OrderbookLevelInfos GetOrderInfos() const;
+    void GetOrderInfos(std::size_t depth, OrderbookDepthInfos& infos) const;
+
+private:
+    struct Level {
+        OrderFifo orders_;
+        Quantity quantity_{};
+    };
+
+    // What the book keeps about a resting order besides its id and remaining quantity, which live in its level.
+    // Packed into two words, with bit fields of one type so every compiler lays them out alike, so a map entry takes
+    // half a cache line.
+    struct RestingOrder {
+        Price price_;
+        std::uint64_t sequence_ : 48;
+        std::uint64_t orderType_ : 8;
+        std::uint64_t side_ : 8;
+
+        RestingOrder() = default;
+        RestingOrder(Price price, OrderFifo::Sequence sequence, OrderType orderType, Side side)
+            : price_{ price }
+            , sequence_{ sequence }
+            , orderType_{ static_cast<std::uint64_t>(orderType) }
+            , side_{ static_cast<std::uint64_t>(side) }
+        {}
+
+        OrderType GetOrderType() const { return static_cast<OrderType>(orderType_); }
+        Side GetSide() const { return static_cast<Side>(side_); }
+    };
+
+    static_assert(sizeof(RestingOrder) == 16 && std::is_trivially_copyable_v<RestingOrder>);
+
+    Price tickSize_;
+    Price base_{};
+    bool initialized_{ false };
+
+    std::vector<Level> levels_;
+    PriceBitmap bidLevels_;
+    PriceBitmap askLevels_;
+    std::size_t bestBid_{ PriceBitmap::npos };
+    std::size_t bestAsk_{ PriceBitmap::npos };
+    FlatHashMap<OrderId, RestingOrder, SequentialIdHash> orders_;
+
+    std::size_t ToIndex(Price price) const { return static_cast<std::size_t>((price - base_) / tickSize_); }
+    Price ToPrice(std::size_t index) const { return base_ + static_cast<Price>(index) * tickSize_; }
+    bool InWindow(Price price) const { return price >= base_ && ToIndex(price) < levels_.size(); }
+
+    std::pair<Price, Price> GetBounds(Price price) const;
+    void ValidatePrice(Price price) const;
+    void EnsureInWindow(Price price);
+    void Recentre(Price price);
+
+    void InsertOrder(const Order& order);
+    void RemoveOrder(const RestingOrder& order);
+    void ClearLevel(Side side, std::size_t index);
+
+    bool CanFullyFill(Side side, Price price, Quantity quantity) const;
+    bool CanMatch(Side side, Price price) const;
+    Trades MatchOrder(Order& order);
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Fixed-precision latency histogram in the style of HdrHistogram. Values below 2^SUB_BUCKET_BITS are counted exactly;
+ * above that, every power of two is split into 2^(SUB_BUCKET_BITS - 1) equal sub-buckets, so any recorded value is
+ * reported within 1/64 of itself whatever its magnitude. Recording is O(1) and never allocates, which keeps it
+ * cheap enough to sit between two timestamps of a measured operation.
+ */
+class LatencyHistogram {
+public:
+	LatencyHistogram();
+
+	void Record(std::uint64_t value);
+	void Merge(const LatencyHistogram& other);
+	void Reset();
+
+	std::uint64_t GetCount() const { return count_; }
+	std::uint64_t GetMin() const { return count_ == 0 ? 0 : min_; }
+	std::uint64_t GetMax() const { return max_; }
+	double GetMean() const;
+
+	// Returns the highest value equivalent to the sample at the given percentile in [0, 1], or 0 without samples.
+	std::uint64_t GetValueAtPercentile(double percentile) const;
+
+private:
+	static constexpr unsigned SUB_BUCKET_BITS = 7;
+	static constexpr std::uint64_t SUB_BUCKET_COUNT = std::uint64_t{ 1 } << SUB_BUCKET_BITS;
+	static constexpr std::uint64_t SUB_BUCKET_HALF_COUNT = SUB_BUCKET_COUNT / 2;
+
+	std::vector<std::uint64_t> counts_;
+	std::uint64_t count_{};
+	std::uint64_t min_{};
+	std::uint64_t max_{};
+	long double total_{};
+
+	static std::size_t GetIndex(std::uint64_t value);
+	static std::uint64_t GetHighestEquivalentValue(std::size_t index);
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <mutex>
+
+/* Synchronization policies for BasicOrderbook.
+ * MutexPolicy guards every operation with a std::mutex, so a book can be shared between threads.
+ * NoLockPolicy compiles the locking away for books that are pinned to a single thread.
+ */
+struct MutexPolicy {
+    using Mutex = std::mutex;
+};
+
+struct NoLockPolicy {
+    struct Mutex {
+        void lock() {}
+        bool try_lock() { return true; }
+        void unlock() {}
+    };
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "Usings.h"
+#include "OrderCommand.h"
+#include "Orderbook.h"
+#include "ThreadPool.h"
+
+/* Runs one UnsyncOrderbook per symbol, spread over shards by symbol id.
+ * Every shard owns its books exclusively and runs on its own ThreadPool worker, so the books never lock.
+ * Submitted commands are appended to the owning shard's queue, which the shard drains in batches.
+ * A shard whose loop throws stops processing; Stop rethrows the first such exception once every shard has finished,
+ * while the destructor, which stops the engine if needed, drops it.
+ */
+class MatchingEngine {
+public:
+    explicit MatchingEngine(std::size_t shardCount);
+    MatchingEngine(const MatchingEngine&) = delete;
+    void operator=(const MatchingEngine&) = delete;
+    MatchingEngine(MatchingEngine&&) = delete;
+    void operator=(MatchingEngine&&) = delete;
+    ~MatchingEngine();
+
+    void Submit(const OrderCommand& command);
+    void Submit(std::span<const OrderCommand> commands);
+    void Stop();
+
+    std::size_t GetShardCount() const { return shards_.size(); }
+    std::size_t GetProcessedCount() const;
+    std::size_t GetTradeCount() const;
+
+private:
+    struct Shard {
+        std::mutex queueMutex_;
+        std::condition_variable queueConditionVariable_;
+        std::vector<OrderCommand> pending_;
+        bool stopping_{ false };
+
+        std::unordered_map<SymbolId, std::unique_ptr<UnsyncOrderbook>> books_;
+        std::atomic<std::size_t> processed_{};
+        std::atomic<std::size_t> trades_{};
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    ThreadPool pool_;
+    std::vector<std::future<void>> workers_;
+    std::atomic<bool> stopped_{ false };
+
+    std::size_t ShardOf(SymbolId symbol) const { return symbol % shards_.size(); }
+
+    void RunShard(Shard& shard);
+};
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <list>
+#include <memory>
 #include <exception>
 #include <format>
 
@@ -12,12 +12,12 @@
 class Order {
 public:
     Order(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity)
-        : orderType_{ orderType }
-        , orderId_{ orderId }
-        , side_{ side }
+        : orderId_{ orderId }
         , price_{ price }
         , initialQuantity_{ quantity }
         , remainingQuantity_{ quantity }
+        , orderType_{ orderType }
+        , side_{ side }
     {}
 
     Order(OrderId orderId, Side side, Quantity quantity) :
@@ -40,6 +40,15 @@ public:
         remainingQuantity_ -= quantity;
     }
 
+    // Lowers the open quantity without counting it as filled, for modifies that keep the order's queue position.
+    void ReduceQuantity(Quantity quantity) {
+        if (quantity > GetRemainingQuantity())
+            throw std::logic_error(std::format("Order ({}) cannot be reduced by more than its remaining quantity.", GetOrderId()));
+
+        initialQuantity_ -= quantity;
+        remainingQuantity_ -= quantity;
+    }
+
     void ToGoodTillCancel(Price price) {
         if (GetOrderType() != OrderType::Market)
             throw std::logic_error(std::format("Order ({}) cannot have its price adjusted, only market orders can.", GetOrderId()));
@@ -49,20 +58,28 @@ public:
     }
 
 private:
-    OrderType orderType_;
+    friend class OrderQueue;
+
+    // Wide fields first and the one-byte enums last, so the whole order, queue links included, fits in a cache line.
     OrderId orderId_;
-    Side side_;
     Price price_;
     Quantity initialQuantity_;
     Quantity remainingQuantity_;
+
+    // Links of the intrusive OrderQueue of the price level this order rests at.
+    Order* prev_{ nullptr };
+    Order* next_{ nullptr };
+
+    OrderType orderType_;
+    Side side_;
 };
 
+static_assert(sizeof(Order) <= 64, "Order should fit in a single cache line.");
+
 using OrderPointer = std::shared_ptr<Order>;
-using OrderPointers = std::list<OrderPointer>;
 
 struct OrderEntry {
-    OrderPointer order_{ nullptr };
-    OrderPointers::iterator location_;
+    Order* order_{ nullptr };
 };
 
 struct LevelData {
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Usings.h"
+#include "OrderType.h"
+#include "Side.h"
+#include "OrderModify.h"
+#include "Trade.h"
+
+enum class OrderCommandType : std::uint8_t {
+	Add,
+	Cancel,
+	Modify
+};
+
+/* Plain order instruction routed to the book of the given symbol.
+ * Cancels only use the order id, modifies ignore the order type.
+ */
+struct OrderCommand {
+	OrderCommandType type_;
+	OrderType orderType_;
+	Side side_;
+	SymbolId symbol_;
+	OrderId orderId_;
+	Price price_;
+	Quantity quantity_;
+};
+
+static_assert(std::is_trivially_copyable_v<OrderCommand>);
+
+/* Applies the command to the given book and returns the trades it caused.
+ */
+template <typename OrderbookType>
+Trades ApplyOrderCommand(OrderbookType& orderbook, const OrderCommand& command) {
+	switch (command.type_) {
+	case OrderCommandType::Add:
+		return orderbook.AddOrder(command.orderType_, command.orderId_, command.side_, command.price_, command.quantity_);
+	case OrderCommandType::Cancel:
+		orderbook.CancelOrder(command.orderId_);
+		return {};
+	case OrderCommandType::Modify:
+		return orderbook.ModifyOrder(OrderModify{ command.orderId_, command.side_, command.price_, command.quantity_ });
+	default:
+		throw std::logic_error("Unsupported OrderCommandType");
+	}
+}
+
+/* Applies the command to the given book, writing the trades it caused into the caller-owned buffer.
+ * Adds go straight into the buffer, so a caller reusing it across commands stops allocating for them.
+ */
+template <typename OrderbookType>
+void ApplyOrderCommand(OrderbookType& orderbook, const OrderCommand& command, Trades& trades) {
+	switch (command.type_) {
+	case OrderCommandType::Add:
+		orderbook.AddOrder(command.orderType_, command.orderId_, command.side_, command.price_, command.quantity_, trades);
+		break;
+	case OrderCommandType::Cancel:
+		trades.clear();
+		orderbook.CancelOrder(command.orderId_);
+		break;
+	case OrderCommandType::Modify:
+		trades = orderbook.ModifyOrder(OrderModify{ command.orderId_, command.side_, command.price_, command.quantity_ });
+		break;
+	default:
+		throw std::logic_error("Unsupported OrderCommandType");
+	}
+}
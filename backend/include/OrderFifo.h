@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Usings.h"
+
+/* Time-priority queue of one price level, stored as a structure of arrays: order ids and remaining quantities sit in
+ * two parallel arrays sharing one allocation, so matching streams through contiguous memory.
+ * Every pushed order gets a sequence number that stays valid until the order leaves the queue, which is all a resting
+ * order needs to find its slot again. Removing an order only zeroes its quantity; dead slots are skipped once they
+ * reach the front, and the consumed prefix is reclaimed the next time the queue runs out of room.
+ */
+class OrderFifo {
+public:
+    using Sequence = std::uint64_t;
+
+    bool Empty() const { return live_ == 0; }
+    std::size_t Size() const { return live_; }
+
+    /* Appends an order and returns its sequence number.
+     * Runs in amortized O(1).
+     */
+    Sequence Push(OrderId orderId, Quantity quantity) {
+        if (tail_ == capacity_)
+            MakeRoom();
+
+        Ids()[tail_] = orderId;
+        Remaining()[tail_] = quantity;
+        ++live_;
+
+        return base_ + tail_++;
+    }
+
+    OrderId FrontId() const { return Ids()[head_]; }
+    Quantity& FrontRemaining() { return Remaining()[head_]; }
+
+    /* Drops the front order, typically once it has been filled.
+     * Runs in amortized O(1).
+     */
+    void PopFront() {
+        Remaining()[head_] = 0;
+        Release();
+    }
+
+    Quantity& RemainingAt(Sequence sequence) { return Remaining()[sequence - base_]; }
+
+    /* Removes the order with the given sequence number and returns the quantity it still had.
+     * Runs in amortized O(1).
+     */
+    Quantity Remove(Sequence sequence) {
+        Quantity& remaining = Remaining()[sequence - base_];
+        const Quantity quantity = remaining;
+
+        remaining = 0;
+        Release();
+
+        return quantity;
+    }
+
+private:
+    static_assert(sizeof(OrderId) == sizeof(Quantity));
+
+    static constexpr std::uint32_t MIN_CAPACITY = 8;
+
+    // Ids in [0, capacity_) followed by remaining quantities in [capacity_, 2 * capacity_).
+    std::unique_ptr<std::uint64_t[]> slots_;
+    Sequence base_{};
+    std::uint32_t head_{};
+    std::uint32_t tail_{};
+    std::uint32_t capacity_{};
+    std::uint32_t live_{};
+
+    OrderId* Ids() const { return slots_.get(); }
+    Quantity* Remaining() const { return slots_.get() + capacity_; }
+
+    void Release() {
+        if (--live_ == 0) {
+            base_ += tail_;
+            head_ = tail_ = 0;
+            return;
+        }
+
+        const Quantity* remaining = Remaining();
+        while (remaining[head_] == 0)
+            ++head_;
+    }
+
+    /* Reclaims the consumed prefix when it makes up at least half of the queue, otherwise doubles the capacity.
+     */
+    void MakeRoom() {
+        const std::uint32_t used = tail_ - head_;
+
+        if (head_ > 0 && used <= capacity_ / 2) {
+            std::copy(Ids() + head_, Ids() + tail_, Ids());
+            std::copy(Remaining() + head_, Remaining() + tail_, Remaining());
+        } else {
+            const std::uint32_t capacity = std::max(MIN_CAPACITY, capacity_ * 2);
+            auto slots = std::make_unique_for_overwrite<std::uint64_t[]>(2 * static_cast<std::size_t>(capacity));
+
+            std::copy(Ids() + head_, Ids() + tail_, slots.get());
+            std::copy(Remaining() + head_, Remaining() + tail_, slots.get() + capacity);
+
+            slots_ = std::move(slots);
+            capacity_ = capacity;
+        }
+
+        base_ += head_;
+        tail_ = used;
+        head_ = 0;
+    }
+};
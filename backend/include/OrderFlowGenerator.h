@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "Usings.h"
+#include "OrderCommand.h"
+#include "Trade.h"
+
+/* Synthetic order flow shaped like a real venue's, for benchmarks. The mid price takes a random walk one tick at a
+ * time, resting orders are placed at a heavy-tailed (Pareto) distance behind the touch so most of them crowd the best
+ * levels, and sizes are log-normal. Passive orders never cross the opposite orders the generator has placed, so when the
+ * mid walks through stale orders they only trade against marketable flow. Commands are drawn from a cancel/modify/add
+ * mix over the orders the generator has placed, with a share of marketable limit orders and of FillAndKill,
+ * FillOrKill, GoodForDay and Market orders.
+ *
+ * Feeding the trades of every command back through OnTrades keeps the generator's view of the resting orders exact,
+ * so cancels and modifies only target orders that still rest. Without it, as with Generate, the generator does not see
+ * fills and some cancels and modifies target orders that have already traded.
+ * Cancels outnumber adds in the default mix, so whenever fewer than minLiveOrders_ orders rest, or none at all, the next
+ * command is an add; the realized mix therefore leans further towards adds than the configured one.
+ */
+class OrderFlowGenerator {
+public:
+	struct Config {
+		unsigned seed_ = 42;
+		SymbolId symbol_ = 0;
+		OrderId firstOrderId_ = 1;
+
+		Price initialMid_ = 30'000'000;
+		double midMoveProbability_ = 0.05;
+
+		std::size_t minLiveOrders_ = 10'000;
+		double cancelShare_ = 0.60;
+		double modifyShare_ = 0.25;
+
+		// Pareto tail index of the distance from the touch in ticks; lower is heavier.
+		double touchDistanceAlpha_ = 1.3;
+		Price maxTouchDistance_ = 1'000;
+		double reduceShare_ = 0.5;
+
+		// Shares of the adds; whatever is left are GoodTillCancel orders.
+		double marketShare_ = 0.02;
+		double fillAndKillShare_ = 0.05;
+		double fillOrKillShare_ = 0.02;
+		double goodForDayShare_ = 0.10;
+		// Share of the resting GoodTillCancel and GoodForDay adds priced through the touch.
+		double marketableShare_ = 0.05;
+
+		double quantityLogMean_ = 4.0;
+		double quantityLogSigma_ = 1.0;
+		Quantity maxQuantity_ = 10'000;
+	};
+
+	OrderFlowGenerator();
+	explicit OrderFlowGenerator(const Config& config);
+
+	OrderCommand Next();
+	std::vector<OrderCommand> Generate(std::size_t count);
+	void OnTrades(const Trades& trades);
+
+	Price GetMid() const { return mid_; }
+
+private:
+	struct LiveOrder {
+		OrderId orderId_;
+		Side side_;
+		Price price_;
+		Quantity quantity_;
+	};
+
+	Config config_;
+	std::mt19937_64 rng_;
+	std::uniform_real_distribution<double> unit_{ 0.0, 1.0 };
+	std::lognormal_distribution<double> quantityDist_;
+	Price mid_;
+	OrderId nextOrderId_;
+	std::vector<LiveOrder> live_;
+	std::unordered_map<OrderId, std::size_t> liveIndex_;
+	// Amount of live orders per price, for the best price of each side.
+	std::map<Price, std::size_t> bidPrices_;
+	std::map<Price, std::size_t> askPrices_;
+
+	OrderCommand NextAdd();
+	OrderCommand NextCancel();
+	OrderCommand NextModify();
+	void InsertLive(const LiveOrder& order);
+	void ReduceLive(OrderId orderId, Quantity quantity);
+	void EraseLive(std::size_t index);
+	void AddLivePrice(Side side, Price price);
+	void RemoveLivePrice(Side side, Price price);
+
+	Side NextSide();
+	Price NextTouchDistance();
+	Price NextPassivePrice(Side side);
+	Price NextMarketablePrice(Side side);
+	Quantity NextQuantity();
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "Usings.h"
+#include "OrderCommand.h"
+#include "Orderbook.h"
+#include "RingBuffer.h"
+
+/* Feeds order commands through a bounded ring buffer into a single book owned by a dedicated matching thread.
+ * The matching thread drains the buffer in batches, so producers never take a lock and never allocate.
+ * The Queue decides how many producers are allowed: OrderGateway accepts any amount, SpscOrderGateway exactly one.
+ * Commands for every symbol go to the same book; use MatchingEngine to spread symbols over books.
+ */
+template <typename Queue>
+class BasicOrderGateway {
+public:
+    using ExecutionHandler = std::function<void(const OrderCommand& command, const Trades& trades)>;
+
+    static constexpr std::size_t DEFAULT_CAPACITY = 1 << 16;
+    static constexpr std::size_t DRAIN_BATCH_SIZE = 256;
+
+    explicit BasicOrderGateway(std::size_t capacity = DEFAULT_CAPACITY, ExecutionHandler handler = {});
+    BasicOrderGateway(const BasicOrderGateway&) = delete;
+    void operator=(const BasicOrderGateway&) = delete;
+    BasicOrderGateway(BasicOrderGateway&&) = delete;
+    void operator=(BasicOrderGateway&&) = delete;
+    ~BasicOrderGateway();
+
+    bool TrySubmit(const OrderCommand& command);
+    void Submit(const OrderCommand& command);
+    void Stop();
+
+    std::size_t GetProcessedCount() const { return processed_.load(std::memory_order_relaxed); }
+    std::size_t GetTradeCount() const { return trades_.load(std::memory_order_relaxed); }
+
+private:
+    Queue queue_;
+    ExecutionHandler handler_;
+    UnsyncOrderbook orderbook_;
+    std::atomic<bool> stopping_{ false };
+    std::atomic<std::size_t> processed_{};
+    std::atomic<std::size_t> trades_{};
+    std::thread matchingThread_;
+
+    void RunMatching();
+};
+
+using OrderGateway = BasicOrderGateway<MpscRingBuffer<OrderCommand>>;
+using SpscOrderGateway = BasicOrderGateway<SpscRingBuffer<OrderCommand>>;
+
+extern template class BasicOrderGateway<MpscRingBuffer<OrderCommand>>;
+extern template class BasicOrderGateway<SpscRingBuffer<OrderCommand>>;
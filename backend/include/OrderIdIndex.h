@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Usings.h"
+#include "Order.h"
+#include "FlatHashMap.h"
+
+enum class OrderIndexMode {
+    Hash,
+    Dense,
+};
+
+/* Maps order ids to their resting orders.
+ * In Hash mode every id lives in a FlatHashMap. In Dense mode, which suits venues that assign ids sequentially,
+ * ids inside a sliding window of pages are stored in a direct-addressed array, so a lookup is a single indexed load.
+ * Ids older than the window, or too far ahead of it, fall back to the hash map.
+ * The window advances as its oldest page empties. When it grows past MAX_WINDOW_PAGES, the orders still resting on
+ * its oldest page are moved to the hash map, so a few long-lived orders can't pin unbounded memory.
+ */
+class OrderIdIndex {
+public:
+    static constexpr std::size_t PAGE_SIZE = 1 << 12;
+    static constexpr std::size_t MAX_WINDOW_PAGES = 1 << 12;
+    static constexpr std::size_t MAX_PAGE_GAP = 16;
+
+    explicit OrderIdIndex(OrderIndexMode mode = OrderIndexMode::Hash) : mode_{ mode } {}
+
+    OrderIndexMode GetMode() const { return mode_; }
+    std::size_t size() const { return size_; }
+
+    void reserve(std::size_t count) {
+        if (mode_ == OrderIndexMode::Hash)
+            fallback_.reserve(count);
+    }
+
+    /* Returns the order with the given id, or nullptr if there is none.
+     * Runs in O(1), with a hash lookup only for ids outside the window.
+     */
+    Order* Find(OrderId orderId) const {
+        if (InWindow(orderId)) {
+            if (Order* order = SlotOf(orderId))
+                return order;
+        }
+
+        if (fallback_.empty())
+            return nullptr;
+
+        const auto it = fallback_.find(orderId);
+        return it == fallback_.end() ? nullptr : it->second;
+    }
+
+    bool Contains(OrderId orderId) const { return Find(orderId) != nullptr; }
+
+    /* Indexes the given order under its id, which must not be indexed yet.
+     * Runs in amortized O(1).
+     */
+    void Insert(Order& order) {
+        const OrderId orderId = order.GetOrderId();
+        ++size_;
+
+        if (mode_ == OrderIndexMode::Dense && Reach(orderId)) {
+            Page& page = *pages_[orderId / PAGE_SIZE - basePage_];
+            page.slots_[orderId % PAGE_SIZE] = &order;
+            ++page.live_;
+            return;
+        }
+
+        fallback_.insert({ orderId, &order });
+    }
+
+    /* Removes the given id from the index and returns its order, or nullptr if it wasn't indexed.
+     * Runs in amortized O(1).
+     */
+    Order* Erase(OrderId orderId) {
+        if (InWindow(orderId)) {
+            Page& page = *pages_[orderId / PAGE_SIZE - basePage_];
+            Order* order = std::exchange(page.slots_[orderId % PAGE_SIZE], nullptr);
+
+            if (order) {
+                --page.live_;
+                --size_;
+                TrimFront();
+                return order;
+            }
+        }
+
+        if (fallback_.empty())
+            return nullptr;
+
+        const auto it = fallback_.find(orderId);
+        if (it == fallback_.end())
+            return nullptr;
+
+        Order* order = it->second;
+        fallback_.erase(it);
+        --size_;
+        return order;
+    }
+
+    /* Calls the given function with every indexed order.
+     * Runs in O(W + N) where W is the amount of window slots and N the amount of orders in the hash map.
+     */
+    template <typename Func>
+    void ForEach(Func&& func) const {
+        for (const auto& page : pages_) {
+            for (Order* order : page->slots_) {
+                if (order)
+                    func(*order);
+            }
+        }
+
+        for (const auto& [_, order] : fallback_)
+            func(*order);
+    }
+
+private:
+    struct Page {
+        std::array<Order*, PAGE_SIZE> slots_{};
+        std::size_t live_{};
+    };
+
+    OrderIndexMode mode_;
+    std::size_t size_{};
+    std::size_t basePage_{};
+    std::deque<std::unique_ptr<Page>> pages_;
+    std::vector<std::unique_ptr<Page>> sparePages_;
+    FlatHashMap<OrderId, Order*> fallback_;
+
+    bool InWindow(OrderId orderId) const {
+        const std::size_t page = orderId / PAGE_SIZE;
+        return page >= basePage_ && page - basePage_ < pages_.size();
+    }
+
+    Order* SlotOf(OrderId orderId) const {
+        return pages_[orderId / PAGE_SIZE - basePage_]->slots_[orderId % PAGE_SIZE];
+    }
+
+    /* Makes sure the window covers the given id, growing it when the id is at most MAX_PAGE_GAP pages ahead.
+     * Returns false when the id has to go to the hash map instead.
+     */
+    bool Reach(OrderId orderId) {
+        const std::size_t page = orderId / PAGE_SIZE;
+
+        if (pages_.empty())
+            basePage_ = page;
+
+        if (page < basePage_ || page >= basePage_ + pages_.size() + MAX_PAGE_GAP)
+            return false;
+
+        while (page >= basePage_ + pages_.size()) {
+            pages_.push_back(AcquirePage());
+
+            if (pages_.size() > MAX_WINDOW_PAGES)
+                EvictFront();
+        }
+
+        return page >= basePage_;
+    }
+
+    std::unique_ptr<Page> AcquirePage() {
+        if (sparePages_.empty())
+            return std::make_unique<Page>();
+
+        auto page = std::move(sparePages_.back());
+        sparePages_.pop_back();
+        return page;
+    }
+
+    void ReleaseFront() {
+        sparePages_.push_back(std::move(pages_.front()));
+        pages_.pop_front();
+        ++basePage_;
+    }
+
+    /* Moves the orders still resting on the oldest page to the hash map and drops the page from the window.
+     */
+    void EvictFront() {
+        Page& page = *pages_.front();
+
+        for (Order*& order : page.slots_) {
+            if (!order)
+                continue;
+
+            fallback_.insert({ order->GetOrderId(), order });
+            order = nullptr;
+        }
+
+        page.live_ = 0;
+        ReleaseFront();
+    }
+
+    /* Advances the window past its empty oldest pages, keeping the newest page so the window keeps its anchor.
+     */
+    void TrimFront() {
+        while (pages_.size() > 1 && pages_.front()->live_ == 0)
+            ReleaseFront();
+    }
+};
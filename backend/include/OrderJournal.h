@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "OrderCommand.h"
+
+/* One journaled command and when it was fed to the book, in nanoseconds from an arbitrary origin.
+ */
+struct JournalEntry {
+	std::uint64_t timestamp_;
+	OrderCommand command_;
+};
+
+using JournalEntries = std::vector<JournalEntry>;
+
+/* Binary journal of every command fed to a book, for replaying production flow offline.
+ * A journal starts with the 8-byte JOURNAL_MAGIC, the last byte of which is the format version, followed by one
+ * fixed-size little-endian record per command:
+ *
+ *     u64 timestamp | u8 command type | u8 order type | u8 side | u8 reserved | u32 symbol | u64 order id | u64 price | u64 quantity
+ *
+ * Fixed-size records let a reader size its buffer up front and seek to any command by its index.
+ */
+struct OrderJournal {
+	static constexpr std::array<char, 8> JOURNAL_MAGIC = { 'O', 'B', 'J', 'O', 'U', 'R', 'N', 1 };
+	static constexpr std::size_t RECORD_SIZE = 40;
+
+	static void Encode(const JournalEntry& entry, char* record);
+	static JournalEntry Decode(const char* record);
+};
+
+/* Appends entries to a new journal file, replacing any file at the given path.
+ */
+class OrderJournalWriter {
+public:
+	explicit OrderJournalWriter(const std::filesystem::path& path);
+
+	void Write(const JournalEntry& entry);
+	void Flush();
+
+private:
+	std::ofstream file_;
+};
+
+/* Streams the entries of a journal file in order.
+ */
+class OrderJournalReader {
+public:
+	explicit OrderJournalReader(const std::filesystem::path& path);
+
+	// Returns false once the journal is exhausted.
+	bool Next(JournalEntry& entry);
+
+	static JournalEntries ReadAll(const std::filesystem::path& path);
+
+private:
+	std::ifstream file_;
+};
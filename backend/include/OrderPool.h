@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Order.h"
+
+/* Slab allocator for Order objects.
+ * Orders are constructed in place inside fixed-size chunks and recycled through an intrusive free list,
+ * so steady-state acquire/release never touches the heap. A growable pool adds chunks geometrically
+ * once the free list runs dry; a fixed pool throws instead. Addresses stay stable for the lifetime
+ * of the pool, so a raw Order* works as a handle.
+ */
+class OrderPool {
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 4096;
+
+    explicit OrderPool(std::size_t capacity = DEFAULT_CAPACITY, bool growable = true)
+        : growable_{ growable }
+    {
+        AddChunk(capacity);
+    }
+
+    OrderPool(const OrderPool&) = delete;
+    void operator=(const OrderPool&) = delete;
+    OrderPool(OrderPool&&) = delete;
+    void operator=(OrderPool&&) = delete;
+    ~OrderPool() = default;
+
+    template <typename... Args>
+    Order* Acquire(Args&&... args) {
+        if (!freeList_) {
+            if (!growable_)
+                throw std::logic_error("OrderPool is exhausted.");
+
+            AddChunk(capacity_);
+        }
+
+        Slot* slot = freeList_;
+        freeList_ = slot->next_;
+        ++size_;
+
+        return std::construct_at(reinterpret_cast<Order*>(slot->storage_), std::forward<Args>(args)...);
+    }
+
+    void Release(Order* order) {
+        std::destroy_at(order);
+
+        Slot* slot = reinterpret_cast<Slot*>(order);
+        slot->next_ = freeList_;
+        freeList_ = slot;
+        --size_;
+    }
+
+    /* Makes sure at least the given amount of orders fit without further allocations.
+     */
+    void Reserve(std::size_t capacity) {
+        if (capacity > capacity_)
+            AddChunk(capacity - capacity_);
+    }
+
+    std::size_t Size() const { return size_; }
+    std::size_t Capacity() const { return capacity_; }
+
+private:
+    // Live orders are never destroyed when the pool goes away.
+    static_assert(std::is_trivially_destructible_v<Order>);
+
+    union Slot {
+        Slot* next_;
+        alignas(Order) unsigned char storage_[sizeof(Order)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks_;
+    Slot* freeList_{ nullptr };
+    std::size_t size_{};
+    std::size_t capacity_{};
+    bool growable_;
+
+    void AddChunk(std::size_t slotCount) {
+        if (slotCount == 0) slotCount = DEFAULT_CAPACITY;
+
+        auto chunk = std::make_unique_for_overwrite<Slot[]>(slotCount);
+
+        // Thread the new slots onto the free list back to front so they are handed out in address order.
+        for (std::size_t i = slotCount; i-- > 0;) {
+            chunk[i].next_ = freeList_;
+            freeList_ = &chunk[i];
+        }
+
+        chunks_.push_back(std::move(chunk));
+        capacity_ += slotCount;
+    }
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#include "Order.h"
+
+/* Intrusive FIFO of the orders resting at a single price level.
+ * The prev/next links live inside Order, so pushing, popping and erasing never allocate,
+ * and an order can be unlinked in O(1) from nothing but a reference to it.
+ * The queue does not own its orders.
+ */
+class OrderQueue {
+public:
+    template <typename ValueType>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_const_t<ValueType>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = ValueType*;
+        using reference = ValueType&;
+
+        Iterator() = default;
+        explicit Iterator(ValueType* order) : order_{ order } {}
+
+        reference operator*() const { return *order_; }
+        pointer operator->() const { return order_; }
+
+        Iterator& operator++() {
+            order_ = order_->next_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator&) const = default;
+
+    private:
+        ValueType* order_{ nullptr };
+    };
+
+    using iterator = Iterator<Order>;
+    using const_iterator = Iterator<const Order>;
+
+    OrderQueue() = default;
+    OrderQueue(const OrderQueue&) = delete;
+    OrderQueue& operator=(const OrderQueue&) = delete;
+
+    // The links only point between orders, so a queue can be moved by handing over its ends.
+    OrderQueue(OrderQueue&& other) noexcept
+        : head_{ other.head_ }
+        , tail_{ other.tail_ }
+        , size_{ other.size_ }
+    {
+        other.head_ = other.tail_ = nullptr;
+        other.size_ = 0;
+    }
+
+    OrderQueue& operator=(OrderQueue&& other) noexcept {
+        if (this != &other) {
+            head_ = other.head_;
+            tail_ = other.tail_;
+            size_ = other.size_;
+            other.head_ = other.tail_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    bool empty() const { return size_ == 0; }
+    std::size_t size() const { return size_; }
+
+    Order& front() { return *head_; }
+    const Order& front() const { return *head_; }
+
+    void push_back(Order& order) {
+        order.prev_ = tail_;
+        order.next_ = nullptr;
+
+        if (tail_) tail_->next_ = &order;
+        else head_ = &order;
+
+        tail_ = &order;
+        ++size_;
+    }
+
+    void pop_front() { erase(*head_); }
+
+    void erase(Order& order) {
+        if (order.prev_) order.prev_->next_ = order.next_;
+        else head_ = order.next_;
+
+        if (order.next_) order.next_->prev_ = order.prev_;
+        else tail_ = order.prev_;
+
+        order.prev_ = order.next_ = nullptr;
+        --size_;
+    }
+
+    iterator begin() { return iterator{ head_ }; }
+    iterator end() { return iterator{}; }
+    const_iterator begin() const { return const_iterator{ head_ }; }
+    const_iterator end() const { return const_iterator{}; }
+
+private:
+    Order* head_{ nullptr };
+    Order* tail_{ nullptr };
+    std::size_t size_{};
+};
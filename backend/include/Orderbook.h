@@ -1,29 +1,34 @@
 #pragma once
 
 #include <map>
-#include <unordered_map>
 #include <thread>
 #include <condition_variable>
 #include <mutex>
 #include <stdexcept>
+#include <optional>
+#include <span>
 
 #include "Usings.h"
 #include "Order.h"
 #include "OrderModify.h"
+#include "OrderPool.h"
+#include "OrderIdIndex.h"
+#include "CumulativeDepthIndex.h"
 #include "OrderbookLevelInfos.h"
+#include "OrderbookDepthInfos.h"
 #include "Trade.h"
 #include "ThreadPool.h"
+#include "WorkStealingThreadPool.h"
+#include "SeqLock.h"
 #include "IOrderbook.h"
+#include "LockPolicy.h"
+#include "ExecutionSink.h"
+#include "OrderCommand.h"
 
-class Orderbook : IOrderbook {
+/* Snapshot strategies shared by every BasicOrderbook instantiation.
+ */
+class OrderbookSnapshotStrategies {
 public:
-    Orderbook();
-    Orderbook(const Orderbook&) = delete;
-    void operator=(const Orderbook&) = delete;
-    Orderbook(Orderbook&&) = delete;
-    void operator=(Orderbook&&) = delete;
-    ~Orderbook();
-
     struct IOrderbookSnapshotStrategy {
         virtual ~IOrderbookSnapshotStrategy() = default;
         virtual OrderbookLevelInfos Generate(const BidMap& bids, const AskMap& asks) const {
@@ -32,38 +37,22 @@ public:
         virtual OrderbookLevelInfos Generate(const BidMap& bids, const AskMap& asks, ThreadPool& pool) const {
             return Generate(bids, asks);
         }
+        virtual OrderbookLevelInfos Generate(const BidMap& bids, const AskMap& asks, WorkStealingThreadPool& pool) const {
+            return Generate(bids, asks);
+        }
+        virtual OrderbookLevelInfos Generate(const BidMap& bids, const AskMap& asks, const LevelDataMap& levels) const {
+            return Generate(bids, asks);
+        }
+        virtual void Generate(const BidMap& bids, const AskMap& asks, const LevelDataMap& levels, std::size_t depth, OrderbookDepthInfos& infos) const;
     };
 
     static const IOrderbookSnapshotStrategy& SequentialStrategy();
     static const IOrderbookSnapshotStrategy& AsyncStrategy();
     static const IOrderbookSnapshotStrategy& ThreadPoolStrategy();
     static const IOrderbookSnapshotStrategy& AsyncThreadPoolStrategy();
-
-    Trades AddOrder(OrderPointer order) override;
-    void CancelOrder(OrderId orderId) override;
-    Trades ModifyOrder(OrderModify order) override;
-
-    std::size_t Size() const override;
-    OrderbookLevelInfos GetOrderInfos(const IOrderbookSnapshotStrategy& strategy) const;
-    OrderbookLevelInfos GetOrderInfos(const IOrderbookSnapshotStrategy& strategy, ThreadPool& pool) const;
+    static const IOrderbookSnapshotStrategy& AggregateStrategy();
 
 private:
-    struct OrderEntry {
-        OrderPointer order_{ nullptr };
-        OrderPointers::iterator location_;
-    };
-
-    struct LevelData {
-        Quantity quantity_{};
-        Quantity count_{};
-
-        enum class Action {
-            Add,
-            Remove,
-            Match,
-        };
-    };
-
     struct SequentialSnapshot : IOrderbookSnapshotStrategy {
         OrderbookLevelInfos Generate(const BidMap& bids, const AskMap& asks) const override;
     };
@@ -74,32 +63,94 @@ private:
 
     struct ThreadPoolSnapshot : IOrderbookSnapshotStrategy {
         OrderbookLevelInfos Generate(const BidMap& bids, const AskMap& asks, ThreadPool& pool) const override;
+        OrderbookLevelInfos Generate(const BidMap& bids, const AskMap& asks, WorkStealingThreadPool& pool) const override;
     };
 
     struct AsyncThreadPoolSnapshot : IOrderbookSnapshotStrategy {
         OrderbookLevelInfos Generate(const BidMap& bids, const AskMap& asks, ThreadPool& pool) const override;
+        OrderbookLevelInfos Generate(const BidMap& bids, const AskMap& asks, WorkStealingThreadPool& pool) const override;
     };
 
-    std::unordered_map<Price, LevelData> data_;
-    std::map<Price, OrderPointers, std::greater<Price>> bids_;
-    std::map<Price, OrderPointers, std::less<Price>> asks_;
-    std::unordered_map<OrderId, OrderEntry> orders_;
-    mutable std::mutex ordersMutex_;
+    struct AggregateSnapshot : IOrderbookSnapshotStrategy {
+        OrderbookLevelInfos Generate(const BidMap& bids, const AskMap& asks, const LevelDataMap& levels) const override;
+        void Generate(const BidMap& bids, const AskMap& asks, const LevelDataMap& levels, std::size_t depth, OrderbookDepthInfos& infos) const override;
+    };
+};
+
+/* Price-time priority orderbook. The LockPolicy decides how operations are synchronized:
+ * Orderbook locks a mutex around every operation, UnsyncOrderbook is for books owned by a single thread.
+ */
+template <typename LockPolicy>
+class BasicOrderbook : public OrderbookSnapshotStrategies, IOrderbook {
+public:
+    BasicOrderbook();
+    explicit BasicOrderbook(OrderIndexMode indexMode);
+    explicit BasicOrderbook(std::size_t orderCapacity, OrderIndexMode indexMode = OrderIndexMode::Hash);
+    BasicOrderbook(const BasicOrderbook&) = delete;
+    void operator=(const BasicOrderbook&) = delete;
+    BasicOrderbook(BasicOrderbook&&) = delete;
+    void operator=(BasicOrderbook&&) = delete;
+    ~BasicOrderbook();
+
+    Trades AddOrder(OrderPointer order) override;
+    Trades AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity) override;
+    void AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity, Trades& trades);
+    void AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity, IExecutionSink& sink);
+    Trades AddOrders(std::span<const OrderCommand> orders);
+    void AddOrders(std::span<const OrderCommand> orders, IExecutionSink& sink);
+    void CancelOrder(OrderId orderId) override;
+    void CancelOrder(OrderId orderId, IExecutionSink& sink);
+    void CancelOrders(std::span<const OrderId> orderIds);
+    void CancelOrders(std::span<const OrderId> orderIds, IExecutionSink& sink);
+    Trades ModifyOrder(OrderModify order) override;
+    void ModifyOrder(OrderModify order, IExecutionSink& sink);
+
+    std::size_t Size() const override;
+    Quantity QuantityUpTo(Side side, Price price) const;
+    std::optional<Price> PriceForQuantity(Side side, Quantity quantity) const;
+    OrderbookLevelInfos GetOrderInfos(const IOrderbookSnapshotStrategy& strategy = SequentialStrategy()) const;
+    OrderbookLevelInfos GetOrderInfos(const IOrderbookSnapshotStrategy& strategy, ThreadPool& pool) const;
+    OrderbookLevelInfos GetOrderInfos(const IOrderbookSnapshotStrategy& strategy, WorkStealingThreadPool& pool) const;
+    void GetOrderInfos(std::size_t depth, OrderbookDepthInfos& infos) const;
+    void GetOrderInfos(const IOrderbookSnapshotStrategy& strategy, std::size_t depth, OrderbookDepthInfos& infos) const;
+
+    void SetPublishDepth(std::size_t depth);
+    OrderbookDepthInfos GetPublishedOrderInfos() const;
+
+private:
+    LevelDataMap data_;
+    CumulativeDepthIndex depthIndex_;
+    BidMap bids_;
+    AskMap asks_;
+    OrderPool pool_;
+    OrderIdIndex orders_;
+    mutable typename LockPolicy::Mutex ordersMutex_;
     std::thread ordersPruneThread_;
-    std::condition_variable shutdownConditionVariable_;
+    std::condition_variable_any shutdownConditionVariable_;
     std::atomic<bool> shutdown_{ false };
+    SeqLock<OrderbookDepthInfos> published_;
+    std::size_t publishDepth_{};
 
     void PruneGoodForDayOrders();
 
-    void CancelOrders(OrderIds orderIds);
-    void CancelOrderInternal(OrderId orderId);
+    void CancelOrderInternal(OrderId orderId, IExecutionSink& sink);
+    void Publish();
 
-    void OnOrderCancelled(OrderPointer order);
-    void OnOrderAdded(OrderPointer order);
-    void OnOrderMatched(Price price, Quantity quantity, bool isFullyFilled);
-    void UpdateLevelData(Price price, Quantity quantity, LevelData::Action action);
+    void OnOrderCancelled(const Order& order, IExecutionSink& sink);
+    void OnOrderAdded(const Order& order, IExecutionSink& sink);
+    void OnOrderMatched(Side side, Price price, Quantity quantity, bool isFullyFilled, IExecutionSink& sink);
+    void UpdateLevelData(Side side, Price price, Quantity quantity, LevelData::Action action, IExecutionSink& sink);
 
     bool CanFullyFill(Side side, Price price, Quantity quantity) const;
+    Quantity WalkQuantityUpTo(Side side, Price price, Quantity limit) const;
+    std::optional<Price> WalkPriceForQuantity(Side side, Quantity quantity) const;
     bool CanMatch(Side side, Price price) const;
-    Trades MatchOrders();
+    void AddOrderInternal(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity, IExecutionSink& sink);
+    void MatchOrder(Order& order, IExecutionSink& sink);
 };
+
+using Orderbook = BasicOrderbook<MutexPolicy>;
+using UnsyncOrderbook = BasicOrderbook<NoLockPolicy>;
+
+extern template class BasicOrderbook<MutexPolicy>;
+extern template class BasicOrderbook<NoLockPolicy>;
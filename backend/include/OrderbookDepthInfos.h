@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <type_traits>
+
+#include "LevelInfo.h"
+
+/* Fixed-capacity snapshot of the best price levels on each side.
+ * Callers own and reuse it, so taking a depth snapshot never allocates.
+ */
+class OrderbookDepthInfos {
+public:
+    static constexpr std::size_t MAX_DEPTH = 20;
+
+    std::span<const LevelInfo> GetBids() const { return { bids_.data(), bidCount_ }; }
+    std::span<const LevelInfo> GetAsks() const { return { asks_.data(), askCount_ }; }
+
+    void Clear() { bidCount_ = askCount_ = 0; }
+    void PushBid(const LevelInfo& level) { bids_[bidCount_++] = level; }
+    void PushAsk(const LevelInfo& level) { asks_[askCount_++] = level; }
+
+private:
+    std::array<LevelInfo, MAX_DEPTH> bids_{};
+    std::array<LevelInfo, MAX_DEPTH> asks_{};
+    std::size_t bidCount_{};
+    std::size_t askCount_{};
+};
+
+// Published through a SeqLock, which copies it as raw words.
+static_assert(std::is_trivially_copyable_v<OrderbookDepthInfos>);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/* Hardware event counters for the calling thread, read around a measured region so benchmarks can report
+ * cache misses next to their timings. Only user-space events are counted.
+ * Backed by perf_event_open on Linux. On other platforms, or when the kernel refuses access, IsAvailable() is false,
+ * GetUnavailableReason() says why and every reading is zero.
+ *
+ * Windows has no user-space interface to the cache-miss counters (reading them takes a kernel driver or an elevated
+ * ETW session), so the MSVC build never reports misses. Collect them with a Linux build of the benchmarks instead,
+ * using GCC 13 or later (or Clang with libstdc++ 13) for <format>:
+ *
+ *     g++ -std=c++20 -O2 -pthread -DCOUNT_ALLOCATIONS -Ibackend/include \
+ *         $(find backend/src -name '*.cpp' ! -name ApiClient.cpp) -o orderbook-benchmarks
+ *     ./orderbook-benchmarks
+ *
+ * on bare metal or a VM that exposes the PMU, with /proc/sys/kernel/perf_event_paranoid at 2 or lower. The
+ * "Measured ... cache misses" lines compare the books; containers usually hide the PMU and print the skip notice.
+ */
+class PerfCounters {
+public:
+	struct Reading {
+		std::uint64_t cacheReferences_{};
+		std::uint64_t cacheMisses_{};
+		std::uint64_t instructions_{};
+	};
+
+	PerfCounters();
+	PerfCounters(const PerfCounters&) = delete;
+	void operator=(const PerfCounters&) = delete;
+	PerfCounters(PerfCounters&&) = delete;
+	void operator=(PerfCounters&&) = delete;
+	~PerfCounters();
+
+	bool IsAvailable() const;
+	// Returns why the counters could not be opened, or nullptr if they are available.
+	const char* GetUnavailableReason() const;
+
+	void Start();
+	Reading Stop();
+
+private:
+	static constexpr int NO_COUNTER = -1;
+
+	std::array<int, 3> counters_;
+	// errno of the first counter that failed to open.
+	int error_{};
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/* Two-level occupancy bitmap over a price ladder.
+ * The summary layer holds one bit per non-empty word, so finding the next/previous occupied level
+ * skips 4096 empty levels per summary word instead of probing them one by one.
+ */
+class PriceBitmap {
+public:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    PriceBitmap() = default;
+    explicit PriceBitmap(std::size_t size)
+        : size_{ size }
+        , words_((size + WORD_BITS - 1) / WORD_BITS)
+        , summary_((words_.size() + WORD_BITS - 1) / WORD_BITS)
+    {}
+
+    std::size_t GetSize() const { return size_; }
+    bool Empty() const { return count_ == 0; }
+    std::size_t Count() const { return count_; }
+
+    bool Test(std::size_t index) const {
+        return (words_[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+    }
+
+    void Set(std::size_t index) {
+        auto& word = words_[index / WORD_BITS];
+        const auto bit = std::uint64_t{ 1 } << (index % WORD_BITS);
+        if (word & bit) return;
+
+        word |= bit;
+        summary_[index / WORD_BITS / WORD_BITS] |= std::uint64_t{ 1 } << ((index / WORD_BITS) % WORD_BITS);
+        ++count_;
+    }
+
+    void Reset(std::size_t index) {
+        auto& word = words_[index / WORD_BITS];
+        const auto bit = std::uint64_t{ 1 } << (index % WORD_BITS);
+        if (!(word & bit)) return;
+
+        word &= ~bit;
+        if (word == 0)
+            summary_[index / WORD_BITS / WORD_BITS] &= ~(std::uint64_t{ 1 } << ((index / WORD_BITS) % WORD_BITS));
+        --count_;
+    }
+
+    /* Returns the first set index >= from, or npos if there is none.
+     */
+    std::size_t FindNext(std::size_t from) const {
+        if (from >= size_) return npos;
+
+        std::size_t wordIndex = from / WORD_BITS;
+        std::uint64_t word = words_[wordIndex] & (~std::uint64_t{ 0 } << (from % WORD_BITS));
+        if (word)
+            return wordIndex * WORD_BITS + std::countr_zero(word);
+
+        const std::size_t next = NextWord(wordIndex + 1);
+        if (next == npos) return npos;
+
+        return next * WORD_BITS + std::countr_zero(words_[next]);
+    }
+
+    /* Returns the last set index <= from, or npos if there is none.
+     */
+    std::size_t FindPrev(std::size_t from) const {
+        if (size_ == 0) return npos;
+        if (from >= size_) from = size_ - 1;
+
+        std::size_t wordIndex = from / WORD_BITS;
+        std::uint64_t word = words_[wordIndex] & (~std::uint64_t{ 0 } >> (WORD_BITS - 1 - from % WORD_BITS));
+        if (word)
+            return wordIndex * WORD_BITS + WORD_BITS - 1 - std::countl_zero(word);
+
+        if (wordIndex == 0) return npos;
+
+        const std::size_t prev = PrevWord(wordIndex - 1);
+        if (prev == npos) return npos;
+
+        return prev * WORD_BITS + WORD_BITS - 1 - std::countl_zero(words_[prev]);
+    }
+
+private:
+    static constexpr std::size_t WORD_BITS = 64;
+
+    std::size_t size_{};
+    std::size_t count_{};
+    std::vector<std::uint64_t> words_;
+    std::vector<std::uint64_t> summary_;
+
+    // First non-empty word index >= from.
+    std::size_t NextWord(std::size_t from) const {
+        if (from >= words_.size()) return npos;
+
+        std::size_t summaryIndex = from / WORD_BITS;
+        std::uint64_t bits = summary_[summaryIndex] & (~std::uint64_t{ 0 } << (from % WORD_BITS));
+
+        while (!bits) {
+            if (++summaryIndex >= summary_.size()) return npos;
+            bits = summary_[summaryIndex];
+        }
+
+        return summaryIndex * WORD_BITS + std::countr_zero(bits);
+    }
+
+    // Last non-empty word index <= from.
+    std::size_t PrevWord(std::size_t from) const {
+        std::size_t summaryIndex = from / WORD_BITS;
+        std::uint64_t bits = summary_[summaryIndex] & (~std::uint64_t{ 0 } >> (WORD_BITS - 1 - from % WORD_BITS));
+
+        while (!bits) {
+            if (summaryIndex == 0) return npos;
+            bits = summary_[--summaryIndex];
+        }
+
+        return summaryIndex * WORD_BITS + WORD_BITS - 1 - std::countl_zero(bits);
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <span>
+
+#include "OrderJournal.h"
+#include "LatencyHistogram.h"
+
+enum class ReplayPace {
+	// Feeds every command as soon as the previous one returns.
+	MaxSpeed,
+	// Feeds every command at its journaled offset from the first one.
+	Recorded
+};
+
+struct ReplayResult {
+	std::size_t commands_{};
+	std::size_t trades_{};
+	std::chrono::nanoseconds duration_{};
+	LatencyHistogram latencies_;
+};
+
+/* Replays journaled commands into the given book and measures every command.
+ * At max speed a command's latency is the time the book took to apply it. At recorded pace the driver spins until each
+ * command is due and measures from that due time instead, so a book that falls behind the recorded flow is charged
+ * for the queueing delay it causes, rather than the slow commands hiding it.
+ */
+template <typename OrderbookType>
+ReplayResult ReplayJournal(OrderbookType& orderbook, std::span<const JournalEntry> entries, ReplayPace pace) {
+	using std::chrono::steady_clock;
+
+	ReplayResult result;
+	if (entries.empty())
+		return result;
+
+	const std::uint64_t origin = entries.front().timestamp_;
+	const auto start = steady_clock::now();
+
+	for (const auto& entry : entries) {
+		auto due = steady_clock::now();
+
+		if (pace == ReplayPace::Recorded) {
+			due = start + std::chrono::nanoseconds(entry.timestamp_ > origin ? entry.timestamp_ - origin : 0);
+			while (steady_clock::now() < due) {}
+		}
+
+		result.trades_ += ApplyOrderCommand(orderbook, entry.command_).size();
+
+		const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now() - due).count();
+		result.latencies_.Record(static_cast<std::uint64_t>(std::max<long long>(0, latency)));
+	}
+
+	result.commands_ = entries.size();
+	result.duration_ = std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now() - start);
+
+	return result;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <span>
+
+/* Command line front end for order journals, taking the arguments after the program name:
+ *
+ *     convert <fixture> <journal>             converts an OrderbookTest fixture into a journal
+ *     record <count> <journal>                journals count commands of the OrderFlowGenerator flow
+ *     replay <journal> [book] [max|recorded]  replays a journal and reports throughput and latencies
+ *
+ * where book is one of orderbook, unsync, ladder, binary or vanilla. Returns the process exit code.
+ */
+int runReplayTool(std::span<char* const> args);
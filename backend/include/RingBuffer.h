@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include "Constants.h"
+
+/* Bounded single-producer/single-consumer ring buffer of trivially copyable values.
+ * Each side owns one index and only reads the other side's index when its cached copy says the buffer is full or empty,
+ * so the indices rarely bounce between cores. The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class SpscRingBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRingBuffer requires a trivially copyable value");
+
+public:
+    explicit SpscRingBuffer(std::size_t capacity)
+        : mask_{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1 }
+        , slots_{ std::make_unique_for_overwrite<T[]>(mask_ + 1) }
+    {}
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    void operator=(const SpscRingBuffer&) = delete;
+
+    /* Appends a value, returning false if the buffer is full. Producer thread only.
+     */
+    bool TryPush(const T& value) {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail - cachedHead_ > mask_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ > mask_)
+                return false;
+        }
+
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* Moves up to maxCount values into the given output and returns how many were moved. Consumer thread only.
+     */
+    std::size_t PopBatch(T* output, std::size_t maxCount) {
+        const auto head = head_.load(std::memory_order_relaxed);
+
+        if (cachedTail_ == head)
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+
+        const std::size_t count = std::min<std::size_t>(cachedTail_ - head, maxCount);
+
+        for (std::size_t i = 0; i < count; ++i)
+            output[i] = slots_[(head + i) & mask_];
+
+        head_.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    std::size_t Capacity() const { return mask_ + 1; }
+
+private:
+    const std::size_t mask_;
+    const std::unique_ptr<T[]> slots_;
+
+    alignas(Constants::CacheLineSize) std::atomic<std::size_t> tail_{ 0 };
+    std::size_t cachedHead_{ 0 };
+
+    alignas(Constants::CacheLineSize) std::atomic<std::size_t> head_{ 0 };
+    std::size_t cachedTail_{ 0 };
+};
+
+/* Bounded multi-producer/single-consumer ring buffer of trivially copyable values.
+ * Producers claim a slot with a CAS on the tail, then publish it through the slot's sequence number,
+ * so a slow producer only delays the consumer at its own slot. The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class MpscRingBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "MpscRingBuffer requires a trivially copyable value");
+
+public:
+    explicit MpscRingBuffer(std::size_t capacity)
+        : mask_{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1 }
+        , slots_{ std::make_unique<Slot[]>(mask_ + 1) }
+    {
+        for (std::size_t i = 0; i <= mask_; ++i)
+            slots_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+
+    MpscRingBuffer(const MpscRingBuffer&) = delete;
+    void operator=(const MpscRingBuffer&) = delete;
+
+    /* Appends a value, returning false if the buffer is full. Safe to call from any amount of producer threads.
+     */
+    bool TryPush(const T& value) {
+        auto tail = tail_.load(std::memory_order_relaxed);
+
+        while (true) {
+            Slot& slot = slots_[tail & mask_];
+            const auto sequence = slot.sequence_.load(std::memory_order_acquire);
+
+            if (sequence == tail) {
+                if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    slot.value_ = value;
+                    slot.sequence_.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (sequence < tail) {
+                return false;
+            } else {
+                tail = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /* Moves up to maxCount published values into the given output and returns how many were moved. Consumer thread only.
+     */
+    std::size_t PopBatch(T* output, std::size_t maxCount) {
+        std::size_t count = 0;
+
+        while (count < maxCount) {
+            Slot& slot = slots_[head_ & mask_];
+
+            if (slot.sequence_.load(std::memory_order_acquire) != head_ + 1)
+                break;
+
+            output[count++] = slot.value_;
+            slot.sequence_.store(head_ + mask_ + 1, std::memory_order_release);
+            ++head_;
+        }
+
+        return count;
+    }
+
+    std::size_t Capacity() const { return mask_ + 1; }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence_;
+        T value_;
+    };
+
+    const std::size_t mask_;
+    const std::unique_ptr<Slot[]> slots_;
+
+    alignas(Constants::CacheLineSize) std::atomic<std::size_t> tail_{ 0 };
+    alignas(Constants::CacheLineSize) std::size_t head_{ 0 };
+};
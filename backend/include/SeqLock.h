@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+/* Single-writer/multi-reader sequence lock around a trivially copyable value.
+ * The writer never waits on readers. Readers copy the value without locking and retry only when a store
+ * overlapped their copy, so they never observe a torn value. The value is held as relaxed atomic words,
+ * which keeps the concurrent copy free of data races, and converted to and from them with std::bit_cast, so the
+ * value only has to be trivially copyable and a whole amount of words, not trivially constructible.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock requires a trivially copyable value");
+    static_assert(sizeof(T) % sizeof(std::uint64_t) == 0, "SeqLock requires a value made of whole 64-bit words");
+
+public:
+    SeqLock() { Store(T{}); }
+    explicit SeqLock(const T& value) { Store(value); }
+
+    SeqLock(const SeqLock&) = delete;
+    void operator=(const SeqLock&) = delete;
+
+    /* Publishes a new value. Must only be called from the single writer thread.
+     */
+    void Store(const T& value) {
+        const auto words = std::bit_cast<Words>(value);
+
+        const auto sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (std::size_t i = 0; i < WORD_COUNT; ++i)
+            words_[i].store(words[i], std::memory_order_relaxed);
+
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    /* Returns a consistent copy of the latest published value. Safe to call from any thread.
+     */
+    T Load() const {
+        Words words;
+
+        while (true) {
+            const auto before = sequence_.load(std::memory_order_acquire);
+
+            if (!(before & 1)) {
+                for (std::size_t i = 0; i < WORD_COUNT; ++i)
+                    words[i] = words_[i].load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if (sequence_.load(std::memory_order_relaxed) == before)
+                    break;
+            }
+
+            std::this_thread::yield();
+        }
+
+        return std::bit_cast<T>(words);
+    }
+
+    /* Returns the amount of values published so far.
+     */
+    std::uint64_t GetVersion() const { return sequence_.load(std::memory_order_acquire) / 2; }
+
+private:
+    static constexpr std::size_t WORD_COUNT = sizeof(T) / sizeof(std::uint64_t);
+    using Words = std::array<std::uint64_t, WORD_COUNT>;
+
+    std::atomic<std::uint64_t> sequence_{ 0 };
+    std::array<std::atomic<std::uint64_t>, WORD_COUNT> words_{};
+};
@@ -1,6 +1,8 @@
 #pragma once
 
-enum class Side {
+#include <cstdint>
+
+enum class Side : std::uint8_t {
 	Buy,
 	Sell
 };
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Usings.h"
+
+/* Vectorized kernels over contiguous price arrays, dispatched at runtime to the widest instruction set the
+ * CPU supports: AVX-512, then AVX2, then plain scalar loops. Every kernel also takes an explicit level, which is clamped
+ * to what the CPU supports, so benchmarks and tests can compare the variants on the same machine.
+ */
+struct SimdKernels {
+	enum class Level {
+		Scalar,
+		Avx2,
+		Avx512,
+	};
+
+	static Level GetLevel();
+	static const char* GetLevelName(Level level);
+
+	// Return the index of the first lowest/highest price, or count if there is none.
+	static std::size_t FindMinPrice(const Price* prices, std::size_t count);
+	static std::size_t FindMinPrice(const Price* prices, std::size_t count, Level level);
+	static std::size_t FindMaxPrice(const Price* prices, std::size_t count);
+	static std::size_t FindMaxPrice(const Price* prices, std::size_t count, Level level);
+};
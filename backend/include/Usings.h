@@ -7,3 +7,4 @@ using Price = std::uint64_t;
 using Quantity = std::uint64_t;
 using OrderId = std::uint64_t;
 using OrderIds = std::vector<OrderId>;
+using SymbolId = std::uint32_t;
@@ -24,6 +24,7 @@ public:
     ~VanillaOrderbook() = default;
 
     Trades AddOrder(OrderPointer order) override;
+    Trades AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity) override;
     void CancelOrder(OrderId orderId) override;
     Trades ModifyOrder(OrderModify order) override;
 
@@ -32,6 +33,10 @@ public:
 
 private:
     std::vector<OrderPointer> orders_;
+    // Prices of orders_ by index, with orders of the other side parked at a price that never wins,
+    // so the best price of each side is one contiguous SIMD scan.
+    std::vector<Price> askPrices_;
+    std::vector<Price> bidPrices_;
 
     const OrderPointer getBestAsk() const;
     const OrderPointer getBestBid() const;
@@ -42,6 +47,11 @@ private:
     void CancelOrders(OrderIds orderIds);
     void CancelOrderInternal(OrderId orderId);
 
+    void PushOrder(OrderPointer order);
+    template <typename Predicate>
+    void EraseOrders(Predicate predicate);
+    const OrderPointer FindBestOrder(Side side, std::size_t index) const;
+
     void OnOrderCancelled(OrderPointer order);
     void OnOrderAdded(OrderPointer order);
     void OnOrderMatched(Price price, Quantity quantity, bool isFullyFilled);
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "Constants.h"
+
+/* Chase-Lev work-stealing deque.
+ * The owning thread pushes and takes at the bottom like a stack, any other thread steals from the top.
+ * Only the last remaining element is contended, and that race is settled by a single CAS on the top.
+ * The buffer doubles when full; retired buffers are kept until the deque dies because thieves may still read them.
+ */
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "WorkStealingDeque requires a trivially copyable value");
+
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 256;
+
+    explicit WorkStealingDeque(std::size_t capacity = DEFAULT_CAPACITY) {
+        buffers_.push_back(std::make_unique<Buffer>(std::bit_ceil(std::max<std::size_t>(capacity, 2))));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    void operator=(const WorkStealingDeque&) = delete;
+
+    /* Pushes a value at the bottom. Owner thread only.
+     */
+    void Push(T value) {
+        const auto bottom = bottom_.load(std::memory_order_relaxed);
+        const auto top = top_.load(std::memory_order_acquire);
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+
+        if (bottom - top > static_cast<std::int64_t>(buffer->mask_))
+            buffer = Grow(buffer, top, bottom);
+
+        buffer->Store(bottom, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /* Takes the most recently pushed value. Owner thread only.
+     */
+    std::optional<T> Take() {
+        const auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        std::optional<T> value = buffer->Load(bottom);
+
+        if (top == bottom) {
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                value = std::nullopt;
+
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return value;
+    }
+
+    /* Steals the oldest value. Safe to call from any thread.
+     */
+    std::optional<T> Steal() {
+        auto top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+            return std::nullopt;
+
+        const T value = buffer_.load(std::memory_order_acquire)->Load(top);
+
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return std::nullopt;
+
+        return value;
+    }
+
+    bool Empty() const {
+        return top_.load(std::memory_order_relaxed) >= bottom_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Buffer {
+        explicit Buffer(std::size_t capacity)
+            : mask_{ capacity - 1 }
+            , slots_{ std::make_unique<std::atomic<T>[]>(capacity) }
+        {}
+
+        T Load(std::int64_t index) const { return slots_[index & mask_].load(std::memory_order_relaxed); }
+        void Store(std::int64_t index, T value) { slots_[index & mask_].store(value, std::memory_order_relaxed); }
+
+        const std::size_t mask_;
+        const std::unique_ptr<std::atomic<T>[]> slots_;
+    };
+
+    alignas(Constants::CacheLineSize) std::atomic<std::int64_t> top_{ 0 };
+    alignas(Constants::CacheLineSize) std::atomic<std::int64_t> bottom_{ 0 };
+    std::atomic<Buffer*> buffer_{ nullptr };
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+
+    Buffer* Grow(Buffer* buffer, std::int64_t top, std::int64_t bottom) {
+        auto grown = std::make_unique<Buffer>((buffer->mask_ + 1) * 2);
+
+        for (auto i = top; i < bottom; ++i)
+            grown->Store(i, buffer->Load(i));
+
+        buffer = grown.get();
+        buffers_.push_back(std::move(grown));
+        buffer_.store(buffer, std::memory_order_release);
+        return buffer;
+    }
+};
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <atomic>
+#include <iterator>
+#include <exception>
+#include <algorithm>
+#include <memory>
+
+#include "WorkStealingDeque.h"
+
+/* Thread pool where every worker owns a Chase-Lev deque.
+ * Tasks submitted from a worker go to its own deque, tasks from outside go to a shared injection queue
+ * which idle workers drain in batches into their deques. Workers that run dry steal from the others,
+ * so a burst of small tasks is spread without every task passing through one mutex.
+ */
+class WorkStealingThreadPool {
+public:
+    explicit WorkStealingThreadPool(size_t threadCount);
+    ~WorkStealingThreadPool();
+
+    // Submit a task and get a future result
+    template<typename Func, typename... Args>
+    auto submit(Func&& f, Args&&... args) -> std::future<decltype(f(args...))>;
+
+    // Submit f(i) for every i in [0, count) with a single enqueue, the future is ready once all of them ran
+    template<typename Func>
+    std::future<void> submit_bulk(size_t count, Func f);
+
+    // Split [first, last) into chunks and run f(chunkFirst, chunkLast, offsetOfChunk) on the pool, blocking until done.
+    // Must not be called from inside the pool.
+    template<typename Iterator, typename Func>
+    void parallel_for(Iterator first, Iterator last, Func f);
+
+    size_t size() const { return workers_.size(); }
+
+private:
+    using Task = std::function<void()>;
+
+    static constexpr size_t CHUNKS_PER_WORKER = 4;
+
+    struct Worker {
+        WorkStealingDeque<Task*> deque_;
+        std::thread thread_;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::deque<Task*> injected_;
+    std::mutex injectedMutex_;
+
+    std::mutex sleepMutex_;
+    std::condition_variable condition_;
+    std::atomic<size_t> pending_{ 0 };
+    std::atomic<bool> stop_{ false };
+
+    static inline thread_local WorkStealingThreadPool* currentPool_ = nullptr;
+    static inline thread_local size_t currentWorker_ = 0;
+
+    void enqueue(std::vector<Task*>& tasks);
+    Task* findTask(size_t index);
+    void workerThread(size_t index);
+};
+
+inline WorkStealingThreadPool::WorkStealingThreadPool(size_t threadCount) {
+    threadCount = std::max<size_t>(1, threadCount);
+
+    // All deques exist before any worker starts stealing from them.
+    for (size_t i = 0; i < threadCount; ++i)
+        workers_.push_back(std::make_unique<Worker>());
+
+    for (size_t i = 0; i < threadCount; ++i)
+        workers_[i]->thread_ = std::thread([this, i] { workerThread(i); });
+}
+
+inline WorkStealingThreadPool::~WorkStealingThreadPool() {
+    {
+        std::scoped_lock lock(sleepMutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker->thread_.joinable()) worker->thread_.join();
+    }
+}
+
+/* Queues the given tasks on the calling worker's deque, or on the injection queue when called from outside the pool,
+ * and wakes up enough workers to run them.
+ */
+inline void WorkStealingThreadPool::enqueue(std::vector<Task*>& tasks) {
+    if (currentPool_ == this) {
+        auto& deque = workers_[currentWorker_]->deque_;
+        for (Task* task : tasks)
+            deque.Push(task);
+    } else {
+        std::scoped_lock lock(injectedMutex_);
+        injected_.insert(injected_.end(), tasks.begin(), tasks.end());
+    }
+
+    pending_.fetch_add(tasks.size(), std::memory_order_release);
+
+    {
+        std::scoped_lock lock(sleepMutex_);
+    }
+
+    if (tasks.size() == 1)
+        condition_.notify_one();
+    else
+        condition_.notify_all();
+}
+
+/* Looks for work in the worker's own deque, then the injection queue, then the other workers' deques.
+ * Takes a fair share of the injection queue at once, so the rest can be stolen instead of locked for.
+ */
+inline WorkStealingThreadPool::Task* WorkStealingThreadPool::findTask(size_t index) {
+    auto& deque = workers_[index]->deque_;
+
+    if (auto task = deque.Take())
+        return *task;
+
+    {
+        std::scoped_lock lock(injectedMutex_);
+
+        if (!injected_.empty()) {
+            const size_t share = std::max<size_t>(1, injected_.size() / workers_.size());
+
+            Task* task = injected_.front();
+            injected_.pop_front();
+
+            for (size_t i = 1; i < share; ++i) {
+                deque.Push(injected_.front());
+                injected_.pop_front();
+            }
+
+            return task;
+        }
+    }
+
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        if (auto task = workers_[(index + i) % workers_.size()]->deque_.Steal())
+            return *task;
+    }
+
+    return nullptr;
+}
+
+inline void WorkStealingThreadPool::workerThread(size_t index) {
+    currentPool_ = this;
+    currentWorker_ = index;
+
+    while (true) {
+        if (Task* task = findTask(index)) {
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            (*task)();
+            delete task;
+            continue;
+        }
+
+        std::unique_lock lock(sleepMutex_);
+
+        // Drain everything that was queued before shutting down.
+        if (stop_ && pending_.load(std::memory_order_acquire) == 0) return;
+
+        condition_.wait(lock, [this] {
+            return stop_ || pending_.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
+
+template<typename Func, typename... Args>
+auto WorkStealingThreadPool::submit(Func&& f, Args&&... args)
+    -> std::future<decltype(f(args...))> {
+    using ReturnType = decltype(f(args...));
+
+    auto taskPtr = std::make_shared<std::packaged_task<ReturnType()>>(
+        std::bind(std::forward<Func>(f), std::forward<Args>(args)...)
+    );
+
+    std::future<ReturnType> res = taskPtr->get_future();
+
+    std::vector<Task*> tasks{ new Task([taskPtr]() { (*taskPtr)(); }) };
+    enqueue(tasks);
+
+    return res;
+}
+
+template<typename Func>
+std::future<void> WorkStealingThreadPool::submit_bulk(size_t count, Func f) {
+    struct BulkState {
+        Func func_;
+        std::atomic<size_t> remaining_;
+        std::atomic<bool> failed_{ false };
+        std::exception_ptr error_;
+        std::promise<void> done_;
+    };
+
+    auto state = std::make_shared<BulkState>(std::move(f), count);
+    std::future<void> res = state->done_.get_future();
+
+    if (count == 0) {
+        state->done_.set_value();
+        return res;
+    }
+
+    std::vector<Task*> tasks;
+    tasks.reserve(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        tasks.push_back(new Task([state, i]() {
+            try {
+                state->func_(i);
+            } catch (...) {
+                if (!state->failed_.exchange(true))
+                    state->error_ = std::current_exception();
+            }
+
+            if (state->remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (state->error_)
+                    state->done_.set_exception(state->error_);
+                else
+                    state->done_.set_value();
+            }
+        }));
+    }
+
+    enqueue(tasks);
+    return res;
+}
+
+template<typename Iterator, typename Func>
+void WorkStealingThreadPool::parallel_for(Iterator first, Iterator last, Func f) {
+    const size_t count = static_cast<size_t>(std::distance(first, last));
+    if (count == 0) return;
+
+    const size_t chunkCount = std::min(count, workers_.size() * CHUNKS_PER_WORKER);
+    const size_t chunkSize = count / chunkCount;
+
+    // Walk the range once to find the chunk boundaries, the first chunks take the leftover elements.
+    std::vector<Iterator> bounds;
+    std::vector<size_t> offsets;
+    bounds.reserve(chunkCount + 1);
+    offsets.reserve(chunkCount + 1);
+    bounds.push_back(first);
+    offsets.push_back(0);
+
+    for (size_t i = 0; i < chunkCount; ++i) {
+        const size_t size = chunkSize + (i < count % chunkCount ? 1 : 0);
+        bounds.push_back(std::next(bounds.back(), size));
+        offsets.push_back(offsets.back() + size);
+    }
+
+    submit_bulk(chunkCount, [&](size_t i) { f(bounds[i], bounds[i + 1], offsets[i]); }).get();
+}
@@ -0,0 +1,87 @@
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#include "AllocationCounter.h"
+
+#if defined(COUNT_ALLOCATIONS)
+namespace {
+	/* One thread's allocation count. Only its own thread writes it, so allocating threads never contend on a shared
+	 * counter; every live counter is linked into a list that GetCount sums. Neither constructing nor linking allocates,
+	 * since the first allocation of a thread is what constructs it.
+	 */
+	struct ThreadAllocationCount {
+		std::atomic<std::size_t> count_{ 0 };
+		ThreadAllocationCount* prev_{};
+		ThreadAllocationCount* next_{};
+
+		ThreadAllocationCount();
+		~ThreadAllocationCount();
+	};
+
+	std::mutex threadCountsMutex;
+	ThreadAllocationCount* threadCounts = nullptr;
+	// Allocations of threads that have already exited.
+	std::size_t exitedThreadsCount = 0;
+
+	ThreadAllocationCount::ThreadAllocationCount() {
+		std::scoped_lock lock{ threadCountsMutex };
+
+		next_ = threadCounts;
+		if (next_)
+			next_->prev_ = this;
+		threadCounts = this;
+	}
+
+	ThreadAllocationCount::~ThreadAllocationCount() {
+		std::scoped_lock lock{ threadCountsMutex };
+
+		exitedThreadsCount += count_.load(std::memory_order_relaxed);
+
+		if (prev_)
+			prev_->next_ = next_;
+		else
+			threadCounts = next_;
+		if (next_)
+			next_->prev_ = prev_;
+	}
+
+	thread_local ThreadAllocationCount threadAllocationCount;
+
+	void* CountedAllocate(std::size_t size) {
+		// A plain load and store instead of a read-modify-write, as no other thread writes this counter.
+		auto& count = threadAllocationCount.count_;
+		count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+		if (void* memory = std::malloc(size == 0 ? 1 : size))
+			return memory;
+
+		throw std::bad_alloc{};
+	}
+}
+
+/* Sums the counts of the live threads and of the ones that have exited.
+ * Runs in O(T) where T is the amount of live threads that have allocated.
+ */
+std::size_t AllocationCounter::GetCount() {
+	std::scoped_lock lock{ threadCountsMutex };
+
+	std::size_t count = exitedThreadsCount;
+	for (auto* threadCount = threadCounts; threadCount; threadCount = threadCount->next_)
+		count += threadCount->count_.load(std::memory_order_relaxed);
+
+	return count;
+}
+
+void* operator new(std::size_t size) { return CountedAllocate(size); }
+void* operator new[](std::size_t size) { return CountedAllocate(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+#else
+std::size_t AllocationCounter::GetCount() {
+	return 0;
+}
+#endif
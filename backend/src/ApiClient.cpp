@@ -61,7 +61,7 @@ void ApiClient::fillOrderbookBinance(Orderbook& orderbook, OrderId& orderId) {
 		double quantity = static_cast<double>(bid.quantity_) / SCALE_FACTOR;
 		std::cout << price << ' ' << quantity << '\n';
 
-		orderbook.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, orderId++, Side::Buy, bid.price_, bid.quantity_));
+		orderbook.AddOrder(OrderType::GoodTillCancel, orderId++, Side::Buy, bid.price_, bid.quantity_);
 	}
 
 	for (const auto& ask : l2data.asks) {
@@ -69,6 +69,6 @@ void ApiClient::fillOrderbookBinance(Orderbook& orderbook, OrderId& orderId) {
 		double quantity = static_cast<double>(ask.quantity_) / SCALE_FACTOR;
 		std::cout << price << ' ' << quantity << '\n';
 
-		orderbook.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, orderId++, Side::Sell, ask.price_, ask.quantity_));
+		orderbook.AddOrder(OrderType::GoodTillCancel, orderId++, Side::Sell, ask.price_, ask.quantity_);
 	}
 }
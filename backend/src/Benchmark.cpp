@@ -1,16 +1,48 @@
 #include <iostream>
 #include <iomanip>
+#include <array>
+#include <fstream>
 
 #include "Benchmark.h"
 #include "Orderbook.h"
 #include "VanillaOrderbook.h"
+#include "LadderOrderbook.h"
+#include "BinarySearchOrderbook.h"
+#include "MatchingEngine.h"
+#include "OrderGateway.h"
+#include "SimdKernels.h"
 
 namespace {
 	constexpr int OUTPUT_PRECISION = 8;
 	constexpr size_t DEFAULT_BENCHMARK_SIZE = 100'000;
+	constexpr size_t LARGE_BENCHMARK_SIZE = 10'000'000;
+	constexpr size_t DEPTH_BENCHMARK_SIZE = 1'000'000;
+	constexpr size_t DEFAULT_DEPTH = 10;
+	constexpr std::array<size_t, 5> ORDERS_PER_LEVEL = { 1, 10, 100, 1'000, 10'000 };
+	constexpr size_t ENGINE_BENCHMARK_SIZE = 1'000'000;
+	constexpr SymbolId ENGINE_SYMBOL_COUNT = 1'000;
+	constexpr size_t FOK_BENCHMARK_LEVELS = 100'000;
+	constexpr size_t MARKET_BENCHMARK_ORDERS_PER_LEVEL = 10;
+	constexpr std::array<size_t, 2> BATCH_SIZES = { 64, 512 };
+	constexpr size_t CANCEL_LATENCY_SAMPLES = 1'000'000;
+	constexpr uint64_t ENGINE_PRICE_RANGE = 100;
+	constexpr double ENGINE_CANCEL_PROBABILITY = 0.2;
+	constexpr size_t SIMD_BENCHMARK_REPETITIONS = 200;
+	constexpr std::array<SimdKernels::Level, 3> SIMD_LEVELS = { SimdKernels::Level::Scalar, SimdKernels::Level::Avx2, SimdKernels::Level::Avx512 };
+	constexpr size_t LATENCY_REPETITIONS = 3;
+	constexpr size_t VANILLA_LATENCY_BENCHMARK_SIZE = 10'000;
+	constexpr size_t ORDER_FLOW_BENCHMARK_SIZE = 1'000'000;
+	constexpr size_t ORDER_FLOW_LIVE_ORDERS = 10'000;
+	constexpr size_t VANILLA_ORDER_FLOW_BENCHMARK_SIZE = 100'000;
+	constexpr size_t VANILLA_ORDER_FLOW_LIVE_ORDERS = 1'000;
+	constexpr const char* LATENCY_REPORT_CSV_PATH = "latency.csv";
+	constexpr const char* LATENCY_REPORT_JSON_PATH = "latency.json";
+	constexpr std::array<std::pair<const char*, double>, 5> LATENCY_PERCENTILES = { {
+		{ "p50", 0.5 }, { "p90", 0.9 }, { "p99", 0.99 }, { "p99.9", 0.999 }, { "max", 1.0 }
+	} };
 }
 
-void runAllBenchmarks(ThreadPool& pool) {
+void runAllBenchmarks(ThreadPool& pool, WorkStealingThreadPool& stealingPool) {
 	std::cout << std::fixed << std::setprecision(OUTPUT_PRECISION);
 
 	runBenchmark<VanillaOrderbook>("VanillaOrderbook::GetOrderInfos()", DEFAULT_BENCHMARK_SIZE, [](VanillaOrderbook& ob) { return ob.GetOrderInfos(); });
@@ -18,4 +50,213 @@ void runAllBenchmarks(ThreadPool& pool) {
 	runBenchmark<Orderbook>("Orderbook::GetOrderInfosAsync()", DEFAULT_BENCHMARK_SIZE, [](Orderbook& ob) { return ob.GetOrderInfos(Orderbook::AsyncStrategy()); });
 	runBenchmark<Orderbook>("Orderbook::GetOrderInfosAsyncPooled()", DEFAULT_BENCHMARK_SIZE, [&](Orderbook& ob) { return ob.GetOrderInfos(Orderbook::AsyncThreadPoolStrategy(), pool); });
 	runBenchmark<Orderbook>("Orderbook::GetOrderInfosPooled()", DEFAULT_BENCHMARK_SIZE, [&](Orderbook& ob) { return ob.GetOrderInfos(Orderbook::ThreadPoolStrategy(), pool); });
+	runBenchmark<Orderbook>("Orderbook::GetOrderInfosAsyncStealing()", DEFAULT_BENCHMARK_SIZE, [&](Orderbook& ob) { return ob.GetOrderInfos(Orderbook::AsyncThreadPoolStrategy(), stealingPool); });
+	runBenchmark<Orderbook>("Orderbook::GetOrderInfosStealing()", DEFAULT_BENCHMARK_SIZE, [&](Orderbook& ob) { return ob.GetOrderInfos(Orderbook::ThreadPoolStrategy(), stealingPool); });
+	runBenchmark<Orderbook>("Orderbook::GetOrderInfosAggregate()", DEFAULT_BENCHMARK_SIZE, [](Orderbook& ob) { return ob.GetOrderInfos(Orderbook::AggregateStrategy()); });
+	runBenchmark<LadderOrderbook>("LadderOrderbook::GetOrderInfos()", DEFAULT_BENCHMARK_SIZE, [](LadderOrderbook& ob) { return ob.GetOrderInfos(); });
+	runBenchmark<BinarySearchOrderbook>("BinarySearchOrderbook::GetOrderInfos()", DEFAULT_BENCHMARK_SIZE, [](BinarySearchOrderbook& ob) { return ob.GetOrderInfos(); });
+
+	runDepthBenchmark<Orderbook>("Orderbook::GetOrderInfos(depth)", DEPTH_BENCHMARK_SIZE, DEFAULT_DEPTH,
+		[](const Orderbook& ob, size_t depth, OrderbookDepthInfos& infos) { ob.GetOrderInfos(depth, infos); });
+	runDepthBenchmark<Orderbook>("Orderbook::GetOrderInfos(Sequential, depth)", DEPTH_BENCHMARK_SIZE, DEFAULT_DEPTH,
+		[](const Orderbook& ob, size_t depth, OrderbookDepthInfos& infos) { ob.GetOrderInfos(Orderbook::SequentialStrategy(), depth, infos); });
+	runDepthBenchmark<LadderOrderbook>("LadderOrderbook::GetOrderInfos(depth)", DEPTH_BENCHMARK_SIZE, DEFAULT_DEPTH,
+		[](const LadderOrderbook& ob, size_t depth, OrderbookDepthInfos& infos) { ob.GetOrderInfos(depth, infos); });
+
+	for (const auto ordersPerLevel : ORDERS_PER_LEVEL) {
+		Orderbook orderbook;
+		prepareLevelsBenchmark(DEFAULT_BENCHMARK_SIZE, ordersPerLevel, orderbook);
+
+		std::cout << "Snapshot scaling with " << ordersPerLevel << " orders per level:\n";
+		runSnapshotBenchmark("Orderbook::GetOrderInfos()", orderbook, [](const Orderbook& ob) { return ob.GetOrderInfos(Orderbook::SequentialStrategy()); });
+		runSnapshotBenchmark("Orderbook::GetOrderInfosAsync()", orderbook, [](const Orderbook& ob) { return ob.GetOrderInfos(Orderbook::AsyncStrategy()); });
+		runSnapshotBenchmark("Orderbook::GetOrderInfosAsyncPooled()", orderbook, [&](const Orderbook& ob) { return ob.GetOrderInfos(Orderbook::AsyncThreadPoolStrategy(), pool); });
+		runSnapshotBenchmark("Orderbook::GetOrderInfosPooled()", orderbook, [&](const Orderbook& ob) { return ob.GetOrderInfos(Orderbook::ThreadPoolStrategy(), pool); });
+		runSnapshotBenchmark("Orderbook::GetOrderInfosAsyncStealing()", orderbook, [&](const Orderbook& ob) { return ob.GetOrderInfos(Orderbook::AsyncThreadPoolStrategy(), stealingPool); });
+		runSnapshotBenchmark("Orderbook::GetOrderInfosStealing()", orderbook, [&](const Orderbook& ob) { return ob.GetOrderInfos(Orderbook::ThreadPoolStrategy(), stealingPool); });
+		runSnapshotBenchmark("Orderbook::GetOrderInfosAggregate()", orderbook, [](const Orderbook& ob) { return ob.GetOrderInfos(Orderbook::AggregateStrategy()); });
+	}
+
+	runBestPriceScanBenchmark(DEFAULT_BENCHMARK_SIZE);
+
+	runAddOrderBenchmark<Orderbook>("Orderbook::AddOrder()", DEFAULT_BENCHMARK_SIZE);
+	runAddOrderBenchmark<LadderOrderbook>("LadderOrderbook::AddOrder()", DEFAULT_BENCHMARK_SIZE);
+	runAddOrderBenchmark<BinarySearchOrderbook>("BinarySearchOrderbook::AddOrder()", DEFAULT_BENCHMARK_SIZE);
+	runAddOrderBenchmark<Orderbook>("Orderbook::AddOrder() replay", LARGE_BENCHMARK_SIZE);
+	runAddOrderBenchmark<LadderOrderbook>("LadderOrderbook::AddOrder() replay", LARGE_BENCHMARK_SIZE);
+	runCancelOrderBenchmark<Orderbook>("Orderbook::CancelOrder()", DEFAULT_BENCHMARK_SIZE);
+	runCancelOrderBenchmark<LadderOrderbook>("LadderOrderbook::CancelOrder()", DEFAULT_BENCHMARK_SIZE);
+	runCancelOrderBenchmark<BinarySearchOrderbook>("BinarySearchOrderbook::CancelOrder()", DEFAULT_BENCHMARK_SIZE);
+	runCancelLatencyBenchmark<Orderbook>("Orderbook::CancelOrder() latency", LARGE_BENCHMARK_SIZE, CANCEL_LATENCY_SAMPLES, OrderIndexMode::Hash);
+	runCancelLatencyBenchmark<Orderbook>("Orderbook::CancelOrder() latency, dense ids", LARGE_BENCHMARK_SIZE, CANCEL_LATENCY_SAMPLES, OrderIndexMode::Dense);
+
+	{
+		UnorderedOrderIndex unordered;
+		OrderIdIndex hashed{ OrderIndexMode::Hash };
+		OrderIdIndex dense{ OrderIndexMode::Dense };
+
+		runOrderIndexBenchmark("std::unordered_map order index", unordered, DEPTH_BENCHMARK_SIZE, LARGE_BENCHMARK_SIZE);
+		runOrderIndexBenchmark("OrderIdIndex (hash)", hashed, DEPTH_BENCHMARK_SIZE, LARGE_BENCHMARK_SIZE);
+		runOrderIndexBenchmark("OrderIdIndex (dense)", dense, DEPTH_BENCHMARK_SIZE, LARGE_BENCHMARK_SIZE);
+	}
+	runModifyOrderBenchmark<Orderbook>("Orderbook::ModifyOrder()", DEFAULT_BENCHMARK_SIZE);
+	runModifyOrderBenchmark<LadderOrderbook>("LadderOrderbook::ModifyOrder()", DEFAULT_BENCHMARK_SIZE);
+	runModifyOrderBenchmark<BinarySearchOrderbook>("BinarySearchOrderbook::ModifyOrder()", DEFAULT_BENCHMARK_SIZE);
+	runAddOrderBenchmark<UnsyncOrderbook>("UnsyncOrderbook::AddOrder()", DEFAULT_BENCHMARK_SIZE);
+	runCancelOrderBenchmark<UnsyncOrderbook>("UnsyncOrderbook::CancelOrder()", DEFAULT_BENCHMARK_SIZE);
+	runLockOverheadBenchmark<Orderbook, UnsyncOrderbook>("Orderbook vs UnsyncOrderbook", DEFAULT_BENCHMARK_SIZE);
+	runTradeReportingBenchmark<Orderbook>("Orderbook::AddOrder() trade reporting", DEFAULT_BENCHMARK_SIZE);
+
+	for (size_t batchSize : BATCH_SIZES)
+		runBatchBenchmark<Orderbook>("Orderbook::AddOrders()/CancelOrders()", DEFAULT_BENCHMARK_SIZE, batchSize);
+
+	runFillOrKillBenchmark<Orderbook>("Orderbook::AddOrder(FillOrKill)", FOK_BENCHMARK_LEVELS, DEFAULT_BENCHMARK_SIZE);
+	runFillOrKillBenchmark<LadderOrderbook>("LadderOrderbook::AddOrder(FillOrKill)", FOK_BENCHMARK_LEVELS, DEFAULT_BENCHMARK_SIZE);
+	runFillOrKillBenchmark<BinarySearchOrderbook>("BinarySearchOrderbook::AddOrder(FillOrKill)", FOK_BENCHMARK_LEVELS, DEFAULT_BENCHMARK_SIZE);
+
+	runMarketOrderBenchmark<Orderbook>("Orderbook::AddOrder(Market)", DEFAULT_BENCHMARK_SIZE, MARKET_BENCHMARK_ORDERS_PER_LEVEL, DEFAULT_BENCHMARK_SIZE);
+	runMarketOrderBenchmark<LadderOrderbook>("LadderOrderbook::AddOrder(Market)", DEFAULT_BENCHMARK_SIZE, MARKET_BENCHMARK_ORDERS_PER_LEVEL, DEFAULT_BENCHMARK_SIZE);
+	runMarketOrderBenchmark<BinarySearchOrderbook>("BinarySearchOrderbook::AddOrder(Market)", DEFAULT_BENCHMARK_SIZE, MARKET_BENCHMARK_ORDERS_PER_LEVEL, DEFAULT_BENCHMARK_SIZE);
+
+	runCacheMissBenchmark<Orderbook>("Orderbook", DEFAULT_BENCHMARK_SIZE, MARKET_BENCHMARK_ORDERS_PER_LEVEL, DEFAULT_BENCHMARK_SIZE);
+	runCacheMissBenchmark<LadderOrderbook>("LadderOrderbook", DEFAULT_BENCHMARK_SIZE, MARKET_BENCHMARK_ORDERS_PER_LEVEL, DEFAULT_BENCHMARK_SIZE);
+
+	{
+		BenchmarkReport report;
+
+		runLatencySuite<Orderbook>("Orderbook", DEFAULT_BENCHMARK_SIZE, LATENCY_REPETITIONS, report);
+		runLatencySuite<UnsyncOrderbook>("UnsyncOrderbook", DEFAULT_BENCHMARK_SIZE, LATENCY_REPETITIONS, report);
+		runLatencySuite<LadderOrderbook>("LadderOrderbook", DEFAULT_BENCHMARK_SIZE, LATENCY_REPETITIONS, report);
+		runLatencySuite<BinarySearchOrderbook>("BinarySearchOrderbook", DEFAULT_BENCHMARK_SIZE, LATENCY_REPETITIONS, report);
+		// VanillaOrderbook scans all of its orders on every operation, so it gets a smaller book.
+		runLatencySuite<VanillaOrderbook>("VanillaOrderbook", VANILLA_LATENCY_BENCHMARK_SIZE, LATENCY_REPETITIONS, report);
+
+		runOrderFlowBenchmark<Orderbook>("Orderbook", ORDER_FLOW_BENCHMARK_SIZE, ORDER_FLOW_LIVE_ORDERS, report);
+		runOrderFlowBenchmark<UnsyncOrderbook>("UnsyncOrderbook", ORDER_FLOW_BENCHMARK_SIZE, ORDER_FLOW_LIVE_ORDERS, report);
+		runOrderFlowBenchmark<LadderOrderbook>("LadderOrderbook", ORDER_FLOW_BENCHMARK_SIZE, ORDER_FLOW_LIVE_ORDERS, report);
+		runOrderFlowBenchmark<BinarySearchOrderbook>("BinarySearchOrderbook", ORDER_FLOW_BENCHMARK_SIZE, ORDER_FLOW_LIVE_ORDERS, report);
+		runOrderFlowBenchmark<VanillaOrderbook>("VanillaOrderbook", VANILLA_ORDER_FLOW_BENCHMARK_SIZE, VANILLA_ORDER_FLOW_LIVE_ORDERS, report);
+
+		writeBenchmarkReport(report);
+	}
+
+	runMatchingEngineBenchmark(ENGINE_BENCHMARK_SIZE, ENGINE_SYMBOL_COUNT, std::max(1u, std::thread::hardware_concurrency()));
+
+	runGatewayLatencyBenchmark<SpscOrderGateway>("SpscOrderGateway::Submit()", ENGINE_BENCHMARK_SIZE);
+	runGatewayLatencyBenchmark<OrderGateway>("OrderGateway::Submit()", ENGINE_BENCHMARK_SIZE);
+}
+
+/* Generates adds around a shared mid price, so books on both sides cross regularly, mixed with cancels of earlier orders.
+ * Symbols are drawn uniformly from [0, symbolCount).
+ */
+std::vector<OrderCommand> prepareOrderCommands(size_t numCommands, SymbolId symbolCount) {
+	std::mt19937 rng(RNG_SEED);
+	std::uniform_int_distribution<SymbolId> symbolDist(0, symbolCount - 1);
+	std::uniform_int_distribution<uint64_t> priceDist(PRICE_MIN, PRICE_MIN + ENGINE_PRICE_RANGE);
+	std::uniform_int_distribution<uint64_t> qtyDist(QTY_MIN, QTY_MAX);
+	std::bernoulli_distribution sideDist(BUY_PROBABILITY);
+	std::bernoulli_distribution cancelDist(ENGINE_CANCEL_PROBABILITY);
+
+	std::vector<OrderCommand> commands;
+	commands.reserve(numCommands);
+
+	OrderId orderId = INITIAL_ORDER_ID;
+
+	for (size_t i = 0; i < numCommands; ++i) {
+		if (!commands.empty() && cancelDist(rng)) {
+			const auto& target = commands[std::uniform_int_distribution<size_t>(0, commands.size() - 1)(rng)];
+			commands.push_back(OrderCommand{ OrderCommandType::Cancel, OrderType::GoodTillCancel, target.side_, target.symbol_, target.orderId_, 0, 0 });
+			continue;
+		}
+
+		const Side side = sideDist(rng) ? Side::Buy : Side::Sell;
+		commands.push_back(OrderCommand{ OrderCommandType::Add, OrderType::GoodTillCancel, side, symbolDist(rng), orderId++, priceDist(rng), qtyDist(rng) });
+	}
+
+	return commands;
+}
+
+/* Replays the same command flow through engines with 1..maxShards shards and reports the throughput of each.
+ */
+void runMatchingEngineBenchmark(size_t numCommands, SymbolId symbolCount, size_t maxShards) {
+	const auto commands = prepareOrderCommands(numCommands, symbolCount);
+	double baseline = 0;
+
+	for (size_t shardCount = 1; shardCount <= maxShards; ++shardCount) {
+		MatchingEngine engine(shardCount);
+
+		auto start = high_resolution_clock::now();
+
+		engine.Submit(commands);
+		engine.Stop();
+
+		auto end = high_resolution_clock::now();
+		auto duration = std::max<long long>(1, duration_cast<milliseconds>(end - start).count());
+		const double throughput = numCommands * MS_TO_SEC / duration;
+
+		if (shardCount == 1)
+			baseline = throughput;
+
+		std::cout << "Processed MatchingEngine with " << shardCount << " shards of " << numCommands << " commands over " << symbolCount
+			<< " symbols in " << duration << "ms (" << engine.GetTradeCount() << " trades)\n";
+		std::cout << "Throughput: " << throughput << " commands/sec, " << throughput / baseline << "x of a single shard\n";
+	}
+}
+
+/* Prints the LATENCY_PERCENTILES of the given latency samples.
+ */
+void printLatencyPercentiles(const LatencyHistogram& latencies) {
+	if (latencies.GetCount() == 0) {
+		std::cout << "Latency: no samples\n";
+		return;
+	}
+
+	std::cout << "Latency:";
+	for (const auto& [name, percentile] : LATENCY_PERCENTILES)
+		std::cout << " " << name << "=" << latencies.GetValueAtPercentile(percentile) << "ns";
+	std::cout << "\n";
+}
+
+/* Writes the report to LATENCY_REPORT_CSV_PATH and LATENCY_REPORT_JSON_PATH in the working directory.
+ */
+void writeBenchmarkReport(const BenchmarkReport& report) {
+	std::ofstream csv(LATENCY_REPORT_CSV_PATH);
+	report.WriteCsv(csv);
+
+	std::ofstream json(LATENCY_REPORT_JSON_PATH);
+	report.WriteJson(json);
+
+	std::cout << "Wrote latency report to " << LATENCY_REPORT_CSV_PATH << " and " << LATENCY_REPORT_JSON_PATH << "\n";
+}
+
+/* Scans numOrders contiguous prices for the best bid and ask with every kernel level the CPU supports,
+ * as VanillaOrderbook does on every match, and reports the time per scan and the bandwidth achieved.
+ */
+void runBestPriceScanBenchmark(size_t numOrders) {
+	std::mt19937 rng(RNG_SEED);
+	std::uniform_int_distribution<uint64_t> priceDist(PRICE_MIN, PRICE_MAX);
+
+	std::vector<Price> prices(numOrders);
+	std::generate(prices.begin(), prices.end(), [&] { return priceDist(rng); });
+
+	for (const auto simdLevel : SIMD_LEVELS) {
+		if (simdLevel > SimdKernels::GetLevel())
+			break;
+
+		size_t found = 0;
+
+		auto start = high_resolution_clock::now();
+		for (size_t i = 0; i < SIMD_BENCHMARK_REPETITIONS; ++i) {
+			found += SimdKernels::FindMinPrice(prices.data(), prices.size(), simdLevel);
+			found += SimdKernels::FindMaxPrice(prices.data(), prices.size(), simdLevel);
+		}
+		auto end = high_resolution_clock::now();
+
+		const size_t scans = 2 * SIMD_BENCHMARK_REPETITIONS;
+		const double ns = std::max<double>(1, static_cast<double>(duration_cast<nanoseconds>(end - start).count()));
+		const double bytes = static_cast<double>(scans * numOrders * sizeof(Price));
+
+		std::cout << "Scanned " << numOrders << " prices for the best price with " << SimdKernels::GetLevelName(simdLevel)
+			<< ": " << ns / scans << "ns per scan, " << bytes / ns << " GB/s (checksum " << found << ")\n";
+	}
 }
@@ -0,0 +1,64 @@
+#include <iomanip>
+
+#include "BenchmarkReport.h"
+
+namespace {
+	constexpr int MEAN_PRECISION = 1;
+
+	std::string EscapeJson(const std::string& text) {
+		std::string escaped;
+		escaped.reserve(text.size());
+
+		for (const char c : text) {
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			escaped += c;
+		}
+
+		return escaped;
+	}
+}
+
+void BenchmarkReport::Add(const std::string& book, const std::string& operation, const LatencyHistogram& histogram) {
+	rows_.push_back(Row{
+		book,
+		operation,
+		histogram.GetCount(),
+		histogram.GetMean(),
+		histogram.GetValueAtPercentile(0.5),
+		histogram.GetValueAtPercentile(0.9),
+		histogram.GetValueAtPercentile(0.99),
+		histogram.GetValueAtPercentile(0.999),
+		histogram.GetMax()
+	});
+}
+
+/* Writes one line per book and operation under a header line. Latencies are in nanoseconds.
+ */
+void BenchmarkReport::WriteCsv(std::ostream& out) const {
+	out << std::fixed << std::setprecision(MEAN_PRECISION);
+	out << "book,operation,samples,mean_ns,p50_ns,p90_ns,p99_ns,p99.9_ns,max_ns\n";
+
+	for (const auto& row : rows_) {
+		out << row.book_ << ',' << row.operation_ << ',' << row.count_ << ',' << row.mean_ << ','
+			<< row.p50_ << ',' << row.p90_ << ',' << row.p99_ << ',' << row.p999_ << ',' << row.max_ << '\n';
+	}
+}
+
+/* Writes an array with one object per book and operation. Latencies are in nanoseconds.
+ */
+void BenchmarkReport::WriteJson(std::ostream& out) const {
+	out << std::fixed << std::setprecision(MEAN_PRECISION);
+	out << "[\n";
+
+	for (std::size_t i = 0; i < rows_.size(); ++i) {
+		const auto& row = rows_[i];
+
+		out << "  { \"book\": \"" << EscapeJson(row.book_) << "\", \"operation\": \"" << EscapeJson(row.operation_)
+			<< "\", \"samples\": " << row.count_ << ", \"mean_ns\": " << row.mean_ << ", \"p50_ns\": " << row.p50_
+			<< ", \"p90_ns\": " << row.p90_ << ", \"p99_ns\": " << row.p99_ << ", \"p99.9_ns\": " << row.p999_ << ", \"max_ns\": " << row.max_ << " }"
+			<< (i + 1 < rows_.size() ? ",\n" : "\n");
+	}
+
+	out << "]\n";
+}
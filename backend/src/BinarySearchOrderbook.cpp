@@ -1,253 +1,196 @@
-#include <numeric>
-#include <chrono>
-#include <ctime>
-#include <future>
-#include <iostream>
+#include <algorithm>
 
 #include "BinarySearchOrderbook.h"
 
-/* Cancels all orders with the given order ids.
- * Runs in O(N^2), where N is the amount of given order ids.
- */
-void BinarySearchOrderbook::CancelOrders(OrderIds orderIds) {
-	for (const auto& orderId : orderIds)
-		CancelOrderInternal(orderId);
+namespace {
+	constexpr std::size_t MIN_COMPACTION_DEAD_COUNT = 64;
 }
 
-/* Cancels the order with the given order id.
- * Runs in O(N) where N is the amount of orders.
+/* Inserts the given order behind every order that beats it on price or time.
+ * Runs in O(log N) to find the slot plus O(K) to shift the K better orders, where N is the amount of orders on its side.
  */
-void BinarySearchOrderbook::CancelOrderInternal(OrderId orderId) {
-	askOrders_.erase(
-		std::remove_if(askOrders_.begin(), askOrders_.end(), [&](const auto& o) {
-			return o->GetOrderId() == orderId;
-			}),
-		askOrders_.end()
-	);
-
-	bidOrders_.erase(
-		std::remove_if(bidOrders_.begin(), bidOrders_.end(), [&](const auto& o) {
-			return o->GetOrderId() == orderId;
-			}),
-		bidOrders_.end()
-	);
-}
+void BinarySearchOrderbook::InsertOrder(std::unique_ptr<Order> order) {
+	auto& orders = GetSide(order->GetSide()).orders_;
+	const Price price = order->GetPrice();
 
-/* Retrieves the order with the best ask given price-time priority or nullptr if there are none.
- * Runs in O(N) where N is the amount of orders.
- */
-const OrderPointer BinarySearchOrderbook::getBestAsk() const {
-	OrderPointer bestAskOrder = nullptr;
+	// The new order goes in front of every order at its own price, since all of them arrived earlier.
+	const auto it = order->GetSide() == Side::Buy
+		? std::lower_bound(orders.begin(), orders.end(), price, [](const std::unique_ptr<Order>& o, Price p) { return o->GetPrice() < p; })
+		: std::lower_bound(orders.begin(), orders.end(), price, [](const std::unique_ptr<Order>& o, Price p) { return o->GetPrice() > p; });
 
-	for (const auto& order : orders_) {
-		if (!order || order->GetSide() != Side::Sell || order->GetRemainingQuantity() == 0) continue;
-
-		if (!bestAskOrder || order->GetPrice() < bestAskOrder->GetPrice()) {
-			bestAskOrder = order;
-		}
-	}
-
-	return bestAskOrder;
+	orders_.insert({ order->GetOrderId(), order.get() });
+	orders.insert(it, std::move(order));
 }
 
-/* Retrieves the order with the best bid given price-time priority or nullptr if there are none.
- * Runs in O(N) where N is the amount of orders.
+/* Pops cancelled orders off the back of the given side, so its back is always the best live order.
+ * Runs in O(D) where D is the amount of cancelled orders popped.
  */
-const OrderPointer BinarySearchOrderbook::getBestBid() const {
-	OrderPointer bestBidOrder = nullptr;
-
-	for (const auto& order : orders_) {
-		if (!order || order->GetSide() != Side::Buy || order->GetRemainingQuantity() == 0) continue;
-
-		if (!bestBidOrder || order->GetPrice() > bestBidOrder->GetPrice()) {
-			bestBidOrder = order;
-		}
+void BinarySearchOrderbook::DropDeadBack(BookSide& side) {
+	while (!side.orders_.empty() && side.orders_.back()->IsFilled()) {
+		side.orders_.pop_back();
+		--side.deadCount_;
 	}
-
-	return bestBidOrder;
 }
 
-/* Retrieves the order with the best ask given price-time priority or nullptr if there are none.
- * Runs in O(N) where N is the amount of orders.
+/* Erases every cancelled order of the given side once they outnumber its live orders.
+ * Runs in O(N) where N is the amount of orders on the side, amortized O(1) per cancel.
  */
-const OrderPointer BinarySearchOrderbook::getWorstAsk() const {
-	OrderPointer bestAskOrder = nullptr;
-
-	for (const auto& order : orders_) {
-		if (!order || order->GetSide() != Side::Sell || order->GetRemainingQuantity() == 0) continue;
+void BinarySearchOrderbook::Compact(BookSide& side) {
+	if (side.deadCount_ < MIN_COMPACTION_DEAD_COUNT || side.deadCount_ * 2 <= side.orders_.size())
+		return;
 
-		if (!bestAskOrder || order->GetPrice() > bestAskOrder->GetPrice()) {
-			bestAskOrder = order;
-		}
-	}
-
-	return bestAskOrder;
+	std::erase_if(side.orders_, [](const std::unique_ptr<Order>& o) { return o->IsFilled(); });
+	side.deadCount_ = 0;
 }
 
-/* Retrieves the order with the best bid given price-time priority or nullptr if there are none.
- * Runs in O(N) where N is the amount of orders.
+/* Returns true if an order on the given side and price can be matched against the best available opposite order.
+ * Runs in O(1).
  */
-const OrderPointer BinarySearchOrderbook::getWorstBid() const {
-	OrderPointer bestBidOrder = nullptr;
-
-	for (const auto& order : orders_) {
-		if (!order || order->GetSide() != Side::Buy || order->GetRemainingQuantity() == 0) continue;
-
-		if (!bestBidOrder || order->GetPrice() < bestBidOrder->GetPrice()) {
-			bestBidOrder = order;
-		}
-	}
-
-	return bestBidOrder;
-}
-
-bool BinarySearchOrderbook::orderExists(OrderId orderId) const {
-	return std::any_of(orders_.begin(), orders_.end(), [&](const OrderPointer& o) {
-		return o && o->GetOrderId() == orderId;
-		});
-}
-
 bool BinarySearchOrderbook::CanMatch(Side side, Price price) const {
-	if (orders_.empty())
-		return false;
+	if (side == Side::Buy)
+		return !asks_.orders_.empty() && price >= asks_.orders_.back()->GetPrice();
 
-	if (side == Side::Buy) {
-		const auto& bestAskOrder = getBestAsk();
-		return price >= bestAskOrder->GetPrice();
-	}
-	else {
-		const auto& bestBidOrder = getBestBid();
-		return price <= bestBidOrder->GetPrice();
-	}
+	return !bids_.orders_.empty() && price <= bids_.orders_.back()->GetPrice();
 }
 
 /* Checks if an order with the given side, price, and quantity can be fully filled.
- * Runs in O(N), where N is the amount of price levels.
+ * Walks the opposite side from its back and stops as soon as the quantity is covered or the limit price is passed.
+ * Runs in O(K) where K is the amount of orders walked.
  */
 bool BinarySearchOrderbook::CanFullyFill(Side side, Price price, Quantity quantity) const {
-	for (const auto& order : orders_) {
-		if (!order || order->GetSide() != (side == Side::Buy ? Side::Sell : Side::Buy)) continue;
-		if (order->GetRemainingQuantity() == 0) continue;
+	if (!CanMatch(side, price)) return false;
 
-		if ((side == Side::Buy && order->GetPrice() > price) ||
-			(side == Side::Sell && order->GetPrice() < price))
-			continue;
+	const auto& orders = GetSide(side == Side::Buy ? Side::Sell : Side::Buy).orders_;
 
-		if (quantity <= order->GetRemainingQuantity())
+	for (auto it = orders.rbegin(); it != orders.rend(); ++it) {
+		const Order& resting = **it;
+		if (side == Side::Buy ? resting.GetPrice() > price : resting.GetPrice() < price)
+			break;
+
+		if (quantity <= resting.GetRemainingQuantity())
 			return true;
 
-		quantity -= order->GetRemainingQuantity();
+		quantity -= resting.GetRemainingQuantity();
 	}
 
 	return false;
 }
 
-/* Matches orders in the orderbook.
- * Runs in O(N * log(M)) where N is the total amount of orders and M is the amount of price levels.
+/* Matches the incoming order against the back of the opposite side.
+ * Market orders have no limit and trade at the price of each order they reach.
+ * Runs in O(F) where F is the amount of resting orders filled.
  */
-Trades BinarySearchOrderbook::MatchOrders() {
+Trades BinarySearchOrderbook::MatchOrder(Order& order) {
 	Trades trades;
 
-	while (true) {
-		OrderPointer bestBid = nullptr;
-		OrderPointer bestAsk = nullptr;
-
-		for (auto& order : orders_) {
-			if (!order || order->GetSide() != Side::Buy || order->GetRemainingQuantity() == 0) continue;
-
-			if (!bestBid || order->GetPrice() > bestBid->GetPrice()) {
-				bestBid = order;
-			}
-		}
-
-		for (auto& order : orders_) {
-			if (!order || order->GetSide() != Side::Sell || order->GetRemainingQuantity() == 0) continue;
-
-			if (!bestAsk || order->GetPrice() < bestAsk->GetPrice()) {
-				bestAsk = order;
-			}
-		}
+	const bool isBuy = order.GetSide() == Side::Buy;
+	const bool isMarket = order.GetOrderType() == OrderType::Market;
+	auto& side = GetSide(isBuy ? Side::Sell : Side::Buy);
 
-		if (!bestBid || !bestAsk || bestBid->GetPrice() < bestAsk->GetPrice()) break;
+	while (!order.IsFilled() && !side.orders_.empty()) {
+		Order& resting = *side.orders_.back();
+		const Price restingPrice = resting.GetPrice();
 
-		Quantity quantity = std::min(bestBid->GetRemainingQuantity(), bestAsk->GetRemainingQuantity());
+		if (!isMarket && (isBuy ? restingPrice > order.GetPrice() : restingPrice < order.GetPrice()))
+			break;
 
-		bestBid->Fill(quantity);
-		bestAsk->Fill(quantity);
+		const Quantity quantity = std::min(order.GetRemainingQuantity(), resting.GetRemainingQuantity());
 
-		//std::cout << "Matched orders " << bestBid->GetOrderId() << " and " << bestAsk->GetOrderId() << '\n';
+		order.Fill(quantity);
+		resting.Fill(quantity);
 
-		trades.push_back(Trade{
-			TradeInfo{ bestBid->GetOrderId(), bestBid->GetPrice(), quantity },
-			TradeInfo{ bestAsk->GetOrderId(), bestAsk->GetPrice(), quantity }
-			});
+		const TradeInfo aggressorTrade{ order.GetOrderId(), isMarket ? restingPrice : order.GetPrice(), quantity };
+		const TradeInfo restingTrade{ resting.GetOrderId(), restingPrice, quantity };
+		trades.push_back(isBuy ? Trade{ aggressorTrade, restingTrade } : Trade{ restingTrade, aggressorTrade });
 
-		orders_.erase(
-			std::remove_if(orders_.begin(), orders_.end(), [](const auto& o) {
-				return o->IsFilled();
-				}),
-			orders_.end()
-		);
+		if (resting.IsFilled()) {
+			orders_.erase(resting.GetOrderId());
+			side.orders_.pop_back();
+			DropDeadBack(side);
+		}
 	}
 
 	return trades;
 }
 
-/* Adds an order to the orderbook.
- * Runs in O(N * log(M)) where N is the total amount of orders and M is the amount of price levels.
+/* Adds a copy of the given order to the orderbook.
+ * Runs in O(F + log N + K), see AddOrder.
  */
 Trades BinarySearchOrderbook::AddOrder(OrderPointer order) {
-	if (!order || orderExists(order->GetOrderId()))
+	return AddOrder(order->GetOrderType(), order->GetOrderId(), order->GetSide(), order->GetPrice(), order->GetRemainingQuantity());
+}
+
+/* Adds an order to the orderbook.
+ * The incoming order is matched from the stack and only gets allocated if some of it rests.
+ * Runs in O(F + log N + K) where F is the amount of resting orders filled, N the amount of orders on its side
+ * and K the amount of orders that beat it.
+ */
+Trades BinarySearchOrderbook::AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity) {
+	if (orders_.contains(orderId))
 		return {};
 
-	if (order->GetOrderType() == OrderType::FillAndKill && !CanMatch(order->GetSide(), order->GetPrice()))
+	if (orderType == OrderType::FillAndKill && !CanMatch(side, price))
 		return {};
 
-	if (order->GetOrderType() == OrderType::Market) {
-		if (order->GetSide() == Side::Buy) {
-			const auto& worstAskOrder = getWorstAsk();
-			if (!worstAskOrder) return {};
-			order->ToGoodTillCancel(worstAskOrder->GetPrice());
-		}
-		else if (order->GetSide() == Side::Sell) {
-			const auto& worstBidOrder = getWorstBid();
-			if (!worstBidOrder) return {};
-			order->ToGoodTillCancel(worstBidOrder->GetPrice());
-		}
-		else
-			return {};
+	// Market orders sweep the opposite side and never rest, whatever is left once the side runs dry is dropped.
+	if (orderType == OrderType::Market) {
+		Order order{ orderId, side, quantity };
+		return MatchOrder(order);
 	}
 
-	if (order->GetOrderType() == OrderType::FillOrKill && !CanFullyFill(order->GetSide(), order->GetPrice(), order->GetInitialQuantity()))
+	if (orderType == OrderType::FillOrKill && !CanFullyFill(side, price, quantity))
 		return {};
 
-	orders_.push_back(order);
+	Order order{ orderType, orderId, side, price, quantity };
+	Trades trades = MatchOrder(order);
+
+	if (!order.IsFilled() && orderType != OrderType::FillAndKill)
+		InsertOrder(std::make_unique<Order>(order));
 
-	return MatchOrders();
+	return trades;
 }
 
-/* Acquires a lock on the orders and then cancels the order with the given order id.
- * Runs in O(log(M)) where M is the number of distinct price levels.
+/* Cancels the order with the given order id by zeroing it in place.
+ * Runs in amortized O(1).
  */
 void BinarySearchOrderbook::CancelOrder(OrderId orderId) {
-	CancelOrderInternal(orderId);
+	auto it = orders_.find(orderId);
+	if (it == orders_.end()) return;
+
+	Order* order = it->second;
+	orders_.erase(it);
+
+	auto& side = GetSide(order->GetSide());
+
+	// A cancelled order reads as filled, which is how matching, snapshots and compaction recognize it.
+	order->ReduceQuantity(order->GetRemainingQuantity());
+	++side.deadCount_;
+
+	DropDeadBack(side);
+	Compact(side);
 }
 
-/* Modifies the order with the given order id by first cancelling the order, and then adding a new order with the modified data.
- * Runs in O(N * log(M)) where N is the total amount of orders and M is the amount of price levels.
+/* Modifies the order with the given order id. A reduction that keeps the side and price lowers the quantity in place;
+ * any other change cancels the order and adds a new order with the modified data.
+ * Runs in O(1) for an in-place reduction, otherwise as CancelOrder followed by AddOrder.
  */
 Trades BinarySearchOrderbook::ModifyOrder(OrderModify order) {
-	OrderType orderType;
-
-	auto it = std::find_if(orders_.begin(), orders_.end(), [&](const auto& o) {
-		return o->GetOrderId() == order.GetOrderId();
-		});
+	auto it = orders_.find(order.GetOrderId());
 	if (it == orders_.end()) return {};
 
-	orderType = (*it)->GetOrderType();
+	Order& existing = *it->second;
+
+	// Reductions at the same side and price keep the order's queue position.
+	if (existing.GetSide() == order.GetSide() && existing.GetPrice() == order.GetPrice() &&
+		order.GetQuantity() > 0 && order.GetQuantity() <= existing.GetRemainingQuantity()) {
+		existing.ReduceQuantity(existing.GetRemainingQuantity() - order.GetQuantity());
+		return {};
+	}
+
+	const OrderType orderType = existing.GetOrderType();
 
 	CancelOrder(order.GetOrderId());
-	return AddOrder(order.ToOrderPointer(orderType));
+	return AddOrder(orderType, order.GetOrderId(), order.GetSide(), order.GetPrice(), order.GetQuantity());
 }
 
 /* Returns the size of the orderbook, i.e. the amount of orders.
@@ -257,34 +200,60 @@ std::size_t BinarySearchOrderbook::Size() const {
 	return orders_.size();
 }
 
-/* Generates a snapshot of the aggregated orderbook based on the selected strategy.
+/* Generates a snapshot of the aggregated orderbook by walking each side from its best order and merging equal prices.
+ * Runs in O(N) where N is the total amount of orders, cancelled ones included.
  */
 OrderbookLevelInfos BinarySearchOrderbook::GetOrderInfos() const {
-	std::map<Price, Quantity, std::greater<Price>> bidTotalMap;
-	std::map<Price, Quantity, std::less<Price>> askTotalMap;
-
-	for (const auto& order : orders_) {
-		if (!order || order->GetRemainingQuantity() == 0) continue;
+	auto aggregate = [](const std::vector<std::unique_ptr<Order>>& orders) {
+		LevelInfos infos;
 
-		auto price = order->GetPrice();
-		auto quantity = order->GetRemainingQuantity();
+		for (auto it = orders.rbegin(); it != orders.rend(); ++it) {
+			const Order& order = **it;
+			if (order.IsFilled()) continue;
 
-		if (order->GetSide() == Side::Buy) {
-			bidTotalMap[price] += quantity;
-		}
-		else {
-			askTotalMap[price] += quantity;
+			if (!infos.empty() && infos.back().price_ == order.GetPrice())
+				infos.back().quantity_ += order.GetRemainingQuantity();
+			else
+				infos.push_back(LevelInfo{ order.GetPrice(), order.GetRemainingQuantity() });
 		}
-	}
 
-	LevelInfos bidInfos, askInfos;
-	for (const auto& [price, total] : bidTotalMap) {
-		bidInfos.push_back(LevelInfo{ price, total });
-	}
+		return infos;
+	};
 
-	for (const auto& [price, total] : askTotalMap) {
-		askInfos.push_back(LevelInfo{ price, total });
-	}
+	return { aggregate(bids_.orders_), aggregate(asks_.orders_) };
+}
+
+/* Fills the given depth snapshot with up to depth of the best levels of each side, by walking each side from its best
+ * order until one more level would start.
+ * Runs in O(K) where K is the amount of orders within the reported levels, cancelled ones included.
+ */
+void BinarySearchOrderbook::GetOrderInfos(std::size_t depth, OrderbookDepthInfos& infos) const {
+	depth = std::min(depth, OrderbookDepthInfos::MAX_DEPTH);
+	infos.Clear();
+
+	auto collect = [depth](const std::vector<std::unique_ptr<Order>>& orders, auto push) {
+		std::size_t levels = 0;
+		LevelInfo level{};
+
+		for (auto it = orders.rbegin(); it != orders.rend(); ++it) {
+			const Order& order = **it;
+			if (order.IsFilled()) continue;
+
+			if (levels > 0 && order.GetPrice() == level.price_) {
+				level.quantity_ += order.GetRemainingQuantity();
+				continue;
+			}
+
+			if (levels > 0) push(level);
+			if (levels == depth) return;
+
+			level = LevelInfo{ order.GetPrice(), order.GetRemainingQuantity() };
+			++levels;
+		}
+
+		if (levels > 0) push(level);
+	};
 
-	return { bidInfos, askInfos };
+	collect(bids_.orders_, [&infos](const LevelInfo& level) { infos.PushBid(level); });
+	collect(asks_.orders_, [&infos](const LevelInfo& level) { infos.PushAsk(level); });
 }
@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <format>
+
+#include "LadderOrderbook.h"
+
+namespace {
+	constexpr std::size_t LADDER_HEADROOM_FACTOR = 2;
+}
+
+LadderOrderbook::LadderOrderbook(Price tickSize, std::size_t levelCount)
+	: tickSize_{ tickSize }
+	, levels_(levelCount)
+	, bidLevels_{ levelCount }
+	, askLevels_{ levelCount }
+{
+	if (tickSize_ == 0 || levelCount == 0)
+		throw std::logic_error("LadderOrderbook requires a non-zero tick size and level count.");
+
+	if (levelCount > MAX_LEVEL_COUNT)
+		throw std::logic_error(std::format("LadderOrderbook holds at most {} levels.", MAX_LEVEL_COUNT));
+}
+
+/* Returns the lowest and the highest of the occupied prices and the given price.
+ * Runs in O(L / 4096) where L is the amount of ladder levels.
+ */
+std::pair<Price, Price> LadderOrderbook::GetBounds(Price price) const {
+	Price low = price;
+	Price high = price;
+
+	if (!bidLevels_.Empty()) {
+		low = std::min(low, ToPrice(bidLevels_.FindNext(0)));
+		high = std::max(high, ToPrice(bestBid_));
+	}
+
+	if (!askLevels_.Empty()) {
+		low = std::min(low, ToPrice(bestAsk_));
+		high = std::max(high, ToPrice(askLevels_.FindPrev(PriceBitmap::npos)));
+	}
+
+	return { low, high };
+}
+
+/* Throws if an order resting at the given price would be off the tick grid or would need more than MAX_LEVEL_COUNT levels.
+ * Called before matching, so a rejected order leaves the book untouched.
+ * Runs in O(1) for a price inside the current window, otherwise O(L / 4096) where L is the amount of ladder levels.
+ */
+void LadderOrderbook::ValidatePrice(Price price) const {
+	if (!initialized_)
+		return;
+
+	if (price % tickSize_ != base_ % tickSize_)
+		throw std::logic_error(std::format("Price ({}) is not a multiple of the tick size.", price));
+
+	if (InWindow(price))
+		return;
+
+	const auto [low, high] = GetBounds(price);
+	if ((high - low) / tickSize_ + 1 > MAX_LEVEL_COUNT / LADDER_HEADROOM_FACTOR)
+		throw std::logic_error(std::format("Price ({}) is too far from the rest of the book.", price));
+}
+
+/* Makes sure the given price maps onto the ladder, anchoring the ladder on the first price seen
+ * and recentring it once the market drifts out of the current window. The price must have passed ValidatePrice.
+ * Runs in O(1), or O(L) when recentring where L is the amount of ladder levels.
+ */
+void LadderOrderbook::EnsureInWindow(Price price) {
+	if (!initialized_) {
+		base_ = price - std::min<Price>(price / tickSize_, levels_.size() / 2) * tickSize_;
+		initialized_ = true;
+		return;
+	}
+
+	if (!InWindow(price))
+		Recentre(price);
+}
+
+/* Rebuilds the ladder around the midpoint of all occupied levels and the given price,
+ * doubling the amount of levels, up to MAX_LEVEL_COUNT, until the occupied span fits with headroom on both sides.
+ * Runs in O(L) where L is the amount of ladder levels.
+ */
+void LadderOrderbook::Recentre(Price price) {
+	const auto [low, high] = GetBounds(price);
+	const std::size_t span = static_cast<std::size_t>((high - low) / tickSize_) + 1;
+	std::size_t levelCount = levels_.size();
+	while (levelCount < span * LADDER_HEADROOM_FACTOR)
+		levelCount = std::min(levelCount * 2, MAX_LEVEL_COUNT);
+
+	const Price mid = low + (high - low) / (2 * tickSize_) * tickSize_;
+	const Price offset = static_cast<Price>(levelCount / 2) * tickSize_;
+	const Price base = mid > offset ? mid - offset : mid % tickSize_;
+
+	std::vector<Level> levels(levelCount);
+	PriceBitmap bidLevels{ levelCount };
+	PriceBitmap askLevels{ levelCount };
+
+	auto moveLevels = [&](const PriceBitmap& from, PriceBitmap& to) {
+		for (auto index = from.FindNext(0); index != PriceBitmap::npos; index = from.FindNext(index + 1)) {
+			const auto newIndex = static_cast<std::size_t>((ToPrice(index) - base) / tickSize_);
+			levels[newIndex] = std::move(levels_[index]);
+			to.Set(newIndex);
+		}
+	};
+
+	moveLevels(bidLevels_, bidLevels);
+	moveLevels(askLevels_, askLevels);
+
+	base_ = base;
+	levels_ = std::move(levels);
+	bidLevels_ = std::move(bidLevels);
+	askLevels_ = std::move(askLevels);
+	bestBid_ = bidLevels_.FindPrev(PriceBitmap::npos);
+	bestAsk_ = askLevels_.FindNext(0);
+}
+
+/* Rests the given order at the back of its price level.
+ * Runs in amortized O(1).
+ */
+void LadderOrderbook::InsertOrder(const Order& order) {
+	const auto index = ToIndex(order.GetPrice());
+	auto& level = levels_[index];
+
+	const auto sequence = level.orders_.Push(order.GetOrderId(), order.GetRemainingQuantity());
+	level.quantity_ += order.GetRemainingQuantity();
+
+	if (order.GetSide() == Side::Buy) {
+		bidLevels_.Set(index);
+		if (bestBid_ == PriceBitmap::npos || index > bestBid_)
+			bestBid_ = index;
+	} else {
+		askLevels_.Set(index);
+		if (bestAsk_ == PriceBitmap::npos || index < bestAsk_)
+			bestAsk_ = index;
+	}
+
+	orders_.insert({ order.GetOrderId(), RestingOrder{ order.GetPrice(), sequence, order.GetOrderType(), order.GetSide() } });
+}
+
+/* Removes the given resting order from its price level.
+ * Runs in amortized O(1), or O(L / 4096) when the best level empties.
+ */
+void LadderOrderbook::RemoveOrder(const RestingOrder& order) {
+	const auto index = ToIndex(order.price_);
+	auto& level = levels_[index];
+
+	level.quantity_ -= level.orders_.Remove(order.sequence_);
+
+	if (level.orders_.Empty())
+		ClearLevel(order.GetSide(), index);
+}
+
+/* Marks the level at the given index as empty, moving the best price of that side if needed.
+ */
+void LadderOrderbook::ClearLevel(Side side, std::size_t index) {
+	levels_[index].quantity_ = 0;
+
+	if (side == Side::Buy) {
+		bidLevels_.Reset(index);
+		if (index == bestBid_)
+			bestBid_ = index == 0 ? PriceBitmap::npos : bidLevels_.FindPrev(index - 1);
+	} else {
+		askLevels_.Reset(index);
+		if (index == bestAsk_)
+			bestAsk_ = askLevels_.FindNext(index + 1);
+	}
+}
+
+/* Checks if an order with the given side, price, and quantity can be fully filled.
+ * Walks the opposite side from the best price towards the limit price and stops as soon as the quantity is covered.
+ * Runs in O(K) where K is the amount of levels touched.
+ */
+bool LadderOrderbook::CanFullyFill(Side side, Price price, Quantity quantity) const {
+	if (!CanMatch(side, price)) return false;
+
+	if (side == Side::Buy) {
+		for (auto index = bestAsk_; index != PriceBitmap::npos && ToPrice(index) <= price; index = askLevels_.FindNext(index + 1)) {
+			if (quantity <= levels_[index].quantity_)
+				return true;
+
+			quantity -= levels_[index].quantity_;
+		}
+	} else {
+		for (auto index = bestBid_; index != PriceBitmap::npos && ToPrice(index) >= price;
+			index = index == 0 ? PriceBitmap::npos : bidLevels_.FindPrev(index - 1)) {
+			if (quantity <= levels_[index].quantity_)
+				return true;
+
+			quantity -= levels_[index].quantity_;
+		}
+	}
+
+	return false;
+}
+
+/* Returns true if an order on the given side and price can be matched against the best available opposite order.
+ * Runs in O(1).
+ */
+bool LadderOrderbook::CanMatch(Side side, Price price) const {
+	if (side == Side::Buy)
+		return bestAsk_ != PriceBitmap::npos && price >= ToPrice(bestAsk_);
+
+	return bestBid_ != PriceBitmap::npos && price <= ToPrice(bestBid_);
+}
+
+/* Matches the incoming order against the opposite side, best level first.
+ * Only the incoming order can cross, so the rest of the book is never revisited, and within a level the fills
+ * walk the contiguous id and quantity arrays of its queue.
+ * Market orders have no limit and trade at the price of each level they reach.
+ * Runs in O(F) where F is the amount of resting orders filled.
+ */
+Trades LadderOrderbook::MatchOrder(Order& order) {
+	Trades trades;
+
+	const bool isBuy = order.GetSide() == Side::Buy;
+	const bool isMarket = order.GetOrderType() == OrderType::Market;
+	const Side restingSide = isBuy ? Side::Sell : Side::Buy;
+	auto& best = isBuy ? bestAsk_ : bestBid_;
+
+	while (!order.IsFilled() && best != PriceBitmap::npos) {
+		const Price levelPrice = ToPrice(best);
+		if (!isMarket && (isBuy ? levelPrice > order.GetPrice() : levelPrice < order.GetPrice()))
+			break;
+
+		auto& level = levels_[best];
+		const OrderId restingId = level.orders_.FrontId();
+		Quantity& restingRemaining = level.orders_.FrontRemaining();
+
+		Quantity quantity = std::min(order.GetRemainingQuantity(), restingRemaining);
+
+		order.Fill(quantity);
+		restingRemaining -= quantity;
+		level.quantity_ -= quantity;
+
+		const TradeInfo aggressorTrade{ order.GetOrderId(), isMarket ? levelPrice : order.GetPrice(), quantity };
+		const TradeInfo restingTrade{ restingId, levelPrice, quantity };
+		trades.push_back(isBuy ? Trade{ aggressorTrade, restingTrade } : Trade{ restingTrade, aggressorTrade });
+
+		if (restingRemaining == 0) {
+			level.orders_.PopFront();
+			orders_.erase(restingId);
+
+			if (level.orders_.Empty())
+				ClearLevel(restingSide, best);
+		}
+	}
+
+	return trades;
+}
+
+/* Adds a copy of the given order to the orderbook.
+ * Runs in O(F) where F is the amount of resting orders filled, plus O(L) if the ladder needs recentring.
+ */
+Trades LadderOrderbook::AddOrder(OrderPointer order) {
+	return AddOrder(order->GetOrderType(), order->GetOrderId(), order->GetSide(), order->GetPrice(), order->GetRemainingQuantity());
+}
+
+/* Adds an order to the orderbook.
+ * The incoming order is matched from the stack and only its level slot and resting record remain if some of it rests.
+ * Throws std::logic_error, before anything is matched, if the order could rest at a price the ladder cannot hold.
+ * Runs in O(F) where F is the amount of resting orders filled, plus O(L) if the ladder needs recentring.
+ */
+Trades LadderOrderbook::AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity) {
+	if (orders_.contains(orderId))
+		return {};
+
+	if (orderType == OrderType::FillAndKill && !CanMatch(side, price))
+		return {};
+
+	// Market orders sweep the opposite side and never rest, whatever is left once the side runs dry is dropped.
+	if (orderType == OrderType::Market) {
+		Order order{ orderId, side, quantity };
+		return MatchOrder(order);
+	}
+
+	if (orderType == OrderType::FillOrKill && !CanFullyFill(side, price, quantity))
+		return {};
+
+	// FillAndKill orders never rest and FillOrKill orders only get here when they fill, so only resting orders are
+	// checked, and before matching so a rejected order never leaves its fills behind.
+	const bool canRest = orderType != OrderType::FillAndKill && orderType != OrderType::FillOrKill;
+	if (canRest)
+		ValidatePrice(price);
+
+	Order order{ orderType, orderId, side, price, quantity };
+	Trades trades = MatchOrder(order);
+
+	if (!order.IsFilled() && canRest) {
+		EnsureInWindow(price);
+		InsertOrder(order);
+	}
+
+	return trades;
+}
+
+/* Cancels the order with the given order id.
+ * Runs in amortized O(1).
+ */
+void LadderOrderbook::CancelOrder(OrderId orderId) {
+	auto it = orders_.find(orderId);
+	if (it == orders_.end()) return;
+
+	const RestingOrder order = it->second;
+	orders_.erase(it);
+
+	RemoveOrder(order);
+}
+
+/* Modifies the order with the given order id. A reduction that keeps the side and price lowers the quantity in place;
+ * any other change cancels the order and adds a new order with the modified data.
+ * Runs in O(1) for an in-place reduction, otherwise O(F) where F is the amount of resting orders filled by the modified order.
+ */
+Trades LadderOrderbook::ModifyOrder(OrderModify order) {
+	auto it = orders_.find(order.GetOrderId());
+	if (it == orders_.end()) return {};
+
+	const RestingOrder existing = it->second;
+	auto& level = levels_[ToIndex(existing.price_)];
+	Quantity& remaining = level.orders_.RemainingAt(existing.sequence_);
+
+	// Reductions at the same side and price keep the order's queue position.
+	if (existing.GetSide() == order.GetSide() && existing.price_ == order.GetPrice() &&
+		order.GetQuantity() > 0 && order.GetQuantity() <= remaining) {
+		level.quantity_ -= remaining - order.GetQuantity();
+		remaining = order.GetQuantity();
+		return {};
+	}
+
+	// Validated before the cancel, so a modify that would be rejected leaves the original order resting.
+	ValidatePrice(order.GetPrice());
+
+	CancelOrder(order.GetOrderId());
+	return AddOrder(existing.GetOrderType(), order.GetOrderId(), order.GetSide(), order.GetPrice(), order.GetQuantity());
+}
+
+/* Returns the size of the orderbook, i.e. the amount of orders.
+ * Runs in O(1).
+ */
+std::size_t LadderOrderbook::Size() const {
+	return orders_.size();
+}
+
+/* Generates a snapshot of the aggregated orderbook from the maintained level quantities.
+ * Runs in O(M) where M is the amount of occupied price levels.
+ */
+OrderbookLevelInfos LadderOrderbook::GetOrderInfos() const {
+	LevelInfos bidInfos;
+	bidInfos.reserve(bidLevels_.Count());
+	for (auto index = bestBid_; index != PriceBitmap::npos; index = index == 0 ? PriceBitmap::npos : bidLevels_.FindPrev(index - 1))
+		bidInfos.push_back(LevelInfo{ ToPrice(index), levels_[index].quantity_ });
+
+	LevelInfos askInfos;
+	askInfos.reserve(askLevels_.Count());
+	for (auto index = bestAsk_; index != PriceBitmap::npos; index = askLevels_.FindNext(index + 1))
+		askInfos.push_back(LevelInfo{ ToPrice(index), levels_[index].quantity_ });
+
+	return { bidInfos, askInfos };
+}
+
+/* Writes the best depth levels of each side into the given caller-owned snapshot.
+ * Runs in O(D) where D is the requested depth.
+ */
+void LadderOrderbook::GetOrderInfos(std::size_t depth, OrderbookDepthInfos& infos) const {
+	depth = std::min(depth, OrderbookDepthInfos::MAX_DEPTH);
+	infos.Clear();
+
+	for (auto index = bestBid_; index != PriceBitmap::npos && infos.GetBids().size() < depth;
+		index = index == 0 ? PriceBitmap::npos : bidLevels_.FindPrev(index - 1))
+		infos.PushBid(LevelInfo{ ToPrice(index), levels_[index].quantity_ });
+
+	for (auto index = bestAsk_; index != PriceBitmap::npos && infos.GetAsks().size() < depth; index = askLevels_.FindNext(index + 1))
+		infos.PushAsk(LevelInfo{ ToPrice(index), levels_[index].quantity_ });
+}
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#include "LatencyHistogram.h"
+
+LatencyHistogram::LatencyHistogram() : counts_(GetIndex(std::numeric_limits<std::uint64_t>::max()) + 1) {
+	Reset();
+}
+
+/* Runs in O(1).
+ */
+void LatencyHistogram::Record(std::uint64_t value) {
+	++counts_[GetIndex(value)];
+	++count_;
+	min_ = std::min(min_, value);
+	max_ = std::max(max_, value);
+	total_ += value;
+}
+
+/* Adds every sample of the given histogram to this one, as if they had been recorded here.
+ * Runs in O(B) where B is the amount of buckets.
+ */
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+	for (std::size_t i = 0; i < counts_.size(); ++i)
+		counts_[i] += other.counts_[i];
+
+	count_ += other.count_;
+	min_ = std::min(min_, other.min_);
+	max_ = std::max(max_, other.max_);
+	total_ += other.total_;
+}
+
+void LatencyHistogram::Reset() {
+	std::fill(counts_.begin(), counts_.end(), 0);
+	count_ = 0;
+	min_ = std::numeric_limits<std::uint64_t>::max();
+	max_ = 0;
+	total_ = 0;
+}
+
+double LatencyHistogram::GetMean() const {
+	return count_ == 0 ? 0 : static_cast<double>(total_ / count_);
+}
+
+/* Runs in O(B) where B is the amount of buckets.
+ */
+std::uint64_t LatencyHistogram::GetValueAtPercentile(double percentile) const {
+	if (count_ == 0)
+		return 0;
+
+	const auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(percentile, 0.0, 1.0) * count_));
+	const std::uint64_t target = std::clamp<std::uint64_t>(rank, 1, count_);
+	std::uint64_t seen = 0;
+
+	for (std::size_t i = 0; i < counts_.size(); ++i) {
+		seen += counts_[i];
+		if (seen >= target)
+			return std::min(GetHighestEquivalentValue(i), max_);
+	}
+
+	return max_;
+}
+
+/* Values below SUB_BUCKET_COUNT map to themselves. Larger values keep their top SUB_BUCKET_BITS bits, which lie in
+ * [SUB_BUCKET_HALF_COUNT, SUB_BUCKET_COUNT), and every bit dropped below them moves the index up by one half-bucket.
+ */
+std::size_t LatencyHistogram::GetIndex(std::uint64_t value) {
+	const auto width = static_cast<unsigned>(std::bit_width(value));
+	const unsigned shift = width > SUB_BUCKET_BITS ? width - SUB_BUCKET_BITS : 0;
+
+	return static_cast<std::size_t>(shift * SUB_BUCKET_HALF_COUNT + (value >> shift));
+}
+
+std::uint64_t LatencyHistogram::GetHighestEquivalentValue(std::size_t index) {
+	if (index < SUB_BUCKET_COUNT)
+		return index;
+
+	const auto shift = static_cast<unsigned>(index / SUB_BUCKET_HALF_COUNT - 1);
+	const std::uint64_t top = index - shift * SUB_BUCKET_HALF_COUNT;
+
+	// Wraps to the maximum for the very last bucket.
+	return ((top + 1) << shift) - 1;
+}
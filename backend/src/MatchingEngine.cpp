@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include "MatchingEngine.h"
+
+namespace {
+	constexpr std::size_t MIN_SHARDS = 1;
+	// Books start small since most symbols are thin; their order pools grow on demand.
+	constexpr std::size_t INITIAL_BOOK_CAPACITY = 256;
+}
+
+MatchingEngine::MatchingEngine(std::size_t shardCount)
+	: pool_{ std::max(MIN_SHARDS, shardCount) }
+{
+	shardCount = std::max(MIN_SHARDS, shardCount);
+
+	shards_.reserve(shardCount);
+	for (std::size_t i = 0; i < shardCount; ++i)
+		shards_.push_back(std::make_unique<Shard>());
+
+	workers_.reserve(shardCount);
+	for (auto& shard : shards_)
+		workers_.push_back(pool_.submit([this, target = shard.get()] { RunShard(*target); }));
+}
+
+MatchingEngine::~MatchingEngine() {
+	// A failed shard is only reported through an explicit Stop, throwing here would terminate.
+	try {
+		Stop();
+	} catch (...) {
+	}
+}
+
+/* Queues a single command on the shard owning its symbol.
+ * Runs in amortized O(1).
+ */
+void MatchingEngine::Submit(const OrderCommand& command) {
+	if (stopped_.load(std::memory_order_acquire))
+		throw std::logic_error("MatchingEngine is stopped.");
+
+	Shard& shard = *shards_[ShardOf(command.symbol_)];
+
+	{
+		std::scoped_lock queueLock{ shard.queueMutex_ };
+
+		// Checked again under the lock, since a shard that is stopping may already have drained its queue for good.
+		if (shard.stopping_)
+			throw std::logic_error("MatchingEngine is stopped.");
+
+		shard.pending_.push_back(command);
+	}
+
+	shard.queueConditionVariable_.notify_one();
+}
+
+/* Queues the given commands, taking every shard's queue lock at most once.
+ * Commands for the same symbol keep their relative order. If the engine is stopped concurrently, the commands of the
+ * shards reached before the stop are still processed.
+ * Runs in O(N) where N is the amount of commands.
+ */
+void MatchingEngine::Submit(std::span<const OrderCommand> commands) {
+	if (stopped_.load(std::memory_order_acquire))
+		throw std::logic_error("MatchingEngine is stopped.");
+
+	std::vector<std::vector<OrderCommand>> batches(shards_.size());
+
+	for (const auto& command : commands)
+		batches[ShardOf(command.symbol_)].push_back(command);
+
+	for (std::size_t i = 0; i < shards_.size(); ++i) {
+		if (batches[i].empty()) continue;
+
+		Shard& shard = *shards_[i];
+
+		{
+			std::scoped_lock queueLock{ shard.queueMutex_ };
+
+			if (shard.stopping_)
+				throw std::logic_error("MatchingEngine is stopped.");
+
+			if (shard.pending_.empty())
+				std::swap(shard.pending_, batches[i]);
+			else
+				shard.pending_.insert(shard.pending_.end(), batches[i].begin(), batches[i].end());
+		}
+
+		shard.queueConditionVariable_.notify_one();
+	}
+}
+
+/* Lets every shard drain the commands queued so far and waits for the shards to finish.
+ * Further submits are rejected. Rethrows the first exception a shard loop threw, after every shard has finished.
+ * Only the first call waits, later and concurrent calls return at once.
+ */
+void MatchingEngine::Stop() {
+	if (stopped_.exchange(true, std::memory_order_acq_rel)) return;
+
+	for (auto& shard : shards_) {
+		{
+			std::scoped_lock queueLock{ shard->queueMutex_ };
+			shard->stopping_ = true;
+		}
+
+		shard->queueConditionVariable_.notify_one();
+	}
+
+	std::exception_ptr failure;
+
+	for (auto& worker : workers_) {
+		try {
+			worker.get();
+		} catch (...) {
+			if (!failure)
+				failure = std::current_exception();
+		}
+	}
+
+	if (failure)
+		std::rethrow_exception(failure);
+}
+
+std::size_t MatchingEngine::GetProcessedCount() const {
+	std::size_t processed = 0;
+	for (const auto& shard : shards_)
+		processed += shard->processed_.load(std::memory_order_relaxed);
+	return processed;
+}
+
+std::size_t MatchingEngine::GetTradeCount() const {
+	std::size_t trades = 0;
+	for (const auto& shard : shards_)
+		trades += shard->trades_.load(std::memory_order_relaxed);
+	return trades;
+}
+
+/* Shard loop: swaps out the whole pending queue and executes it against the shard's books until stopped and drained.
+ */
+void MatchingEngine::RunShard(Shard& shard) {
+	std::vector<OrderCommand> batch;
+	Trades executed;
+
+	while (true) {
+		{
+			std::unique_lock queueLock{ shard.queueMutex_ };
+			shard.queueConditionVariable_.wait(queueLock, [&shard] { return shard.stopping_ || !shard.pending_.empty(); });
+
+			if (shard.pending_.empty())
+				return;
+
+			std::swap(batch, shard.pending_);
+		}
+
+		std::size_t trades = 0;
+
+		for (const auto& command : batch) {
+			auto& orderbook = shard.books_[command.symbol_];
+			if (!orderbook)
+				orderbook = std::make_unique<UnsyncOrderbook>(INITIAL_BOOK_CAPACITY);
+
+			ApplyOrderCommand(*orderbook, command, executed);
+			trades += executed.size();
+		}
+
+		shard.processed_.fetch_add(batch.size(), std::memory_order_relaxed);
+		shard.trades_.fetch_add(trades, std::memory_order_relaxed);
+		batch.clear();
+	}
+}
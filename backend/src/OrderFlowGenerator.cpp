@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+
+#include "OrderFlowGenerator.h"
+#include "Constants.h"
+
+OrderFlowGenerator::OrderFlowGenerator() : OrderFlowGenerator(Config{}) {}
+
+OrderFlowGenerator::OrderFlowGenerator(const Config& config)
+	: config_{ config }
+	, rng_{ config.seed_ }
+	, quantityDist_{ config.quantityLogMean_, config.quantityLogSigma_ }
+	, mid_{ std::max(config.initialMid_, config.maxTouchDistance_ + 2) }
+	, nextOrderId_{ config.firstOrderId_ }
+{
+	live_.reserve(config.minLiveOrders_);
+	liveIndex_.reserve(config.minLiveOrders_);
+}
+
+/* Moves the mid price with probability midMoveProbability_ and draws the next command.
+ * Runs in amortized O(1).
+ */
+OrderCommand OrderFlowGenerator::Next() {
+	if (unit_(rng_) < config_.midMoveProbability_) {
+		// Keeps the deepest passive bid above zero.
+		if (unit_(rng_) < 0.5)
+			++mid_;
+		else
+			mid_ = std::max(mid_ - 1, config_.maxTouchDistance_ + 2);
+	}
+
+	// Cancels and modifies need a live order to pick, even when minLiveOrders_ is zero.
+	if (live_.empty() || live_.size() < config_.minLiveOrders_)
+		return NextAdd();
+
+	const double action = unit_(rng_);
+
+	if (action < config_.cancelShare_)
+		return NextCancel();
+	if (action < config_.cancelShare_ + config_.modifyShare_)
+		return NextModify();
+
+	return NextAdd();
+}
+
+/* Generates the given amount of commands without feedback, see the class comment.
+ */
+std::vector<OrderCommand> OrderFlowGenerator::Generate(std::size_t count) {
+	std::vector<OrderCommand> commands;
+	commands.reserve(count);
+
+	for (std::size_t i = 0; i < count; ++i)
+		commands.push_back(Next());
+
+	return commands;
+}
+
+/* Takes the filled quantities of the given trades, from the last command, off the orders believed to rest.
+ * Runs in O(T) where T is the amount of trades.
+ */
+void OrderFlowGenerator::OnTrades(const Trades& trades) {
+	for (const auto& trade : trades) {
+		ReduceLive(trade.GetBidTrade().orderId_, trade.GetBidTrade().quantity_);
+		ReduceLive(trade.GetAskTrade().orderId_, trade.GetAskTrade().quantity_);
+	}
+}
+
+void OrderFlowGenerator::InsertLive(const LiveOrder& order) {
+	liveIndex_.insert({ order.orderId_, live_.size() });
+	live_.push_back(order);
+	AddLivePrice(order.side_, order.price_);
+}
+
+void OrderFlowGenerator::ReduceLive(OrderId orderId, Quantity quantity) {
+	const auto it = liveIndex_.find(orderId);
+	if (it == liveIndex_.end()) return;
+
+	LiveOrder& order = live_[it->second];
+	order.quantity_ -= std::min(quantity, order.quantity_);
+
+	if (order.quantity_ == 0)
+		EraseLive(it->second);
+}
+
+void OrderFlowGenerator::EraseLive(std::size_t index) {
+	RemoveLivePrice(live_[index].side_, live_[index].price_);
+	liveIndex_.erase(live_[index].orderId_);
+
+	if (index + 1 != live_.size()) {
+		live_[index] = live_.back();
+		liveIndex_[live_[index].orderId_] = index;
+	}
+
+	live_.pop_back();
+}
+
+void OrderFlowGenerator::AddLivePrice(Side side, Price price) {
+	++(side == Side::Buy ? bidPrices_ : askPrices_)[price];
+}
+
+void OrderFlowGenerator::RemoveLivePrice(Side side, Price price) {
+	auto& prices = side == Side::Buy ? bidPrices_ : askPrices_;
+	const auto it = prices.find(price);
+
+	if (--it->second == 0)
+		prices.erase(it);
+}
+
+OrderCommand OrderFlowGenerator::NextAdd() {
+	const Side side = NextSide();
+	const OrderId orderId = nextOrderId_++;
+	const Quantity quantity = NextQuantity();
+
+	const double type = unit_(rng_);
+	double threshold = config_.marketShare_;
+
+	if (type < threshold)
+		return OrderCommand{ OrderCommandType::Add, OrderType::Market, side, config_.symbol_, orderId, Constants::InvalidPrice, quantity };
+
+	// FillAndKill and FillOrKill orders are only ever sent to take liquidity, so they are always priced through the touch.
+	if (type < (threshold += config_.fillAndKillShare_))
+		return OrderCommand{ OrderCommandType::Add, OrderType::FillAndKill, side, config_.symbol_, orderId, NextMarketablePrice(side), quantity };
+	if (type < (threshold += config_.fillOrKillShare_))
+		return OrderCommand{ OrderCommandType::Add, OrderType::FillOrKill, side, config_.symbol_, orderId, NextMarketablePrice(side), quantity };
+
+	const OrderType orderType = type < threshold + config_.goodForDayShare_ ? OrderType::GoodForDay : OrderType::GoodTillCancel;
+	const Price price = unit_(rng_) < config_.marketableShare_ ? NextMarketablePrice(side) : NextPassivePrice(side);
+
+	InsertLive(LiveOrder{ orderId, side, price, quantity });
+
+	return OrderCommand{ OrderCommandType::Add, orderType, side, config_.symbol_, orderId, price, quantity };
+}
+
+OrderCommand OrderFlowGenerator::NextCancel() {
+	const auto index = std::uniform_int_distribution<std::size_t>(0, live_.size() - 1)(rng_);
+	const LiveOrder order = live_[index];
+
+	EraseLive(index);
+
+	return OrderCommand{ OrderCommandType::Cancel, OrderType::GoodTillCancel, order.side_, config_.symbol_, order.orderId_, 0, 0 };
+}
+
+/* Either reduces the order at its price, which books apply in place, or moves it to a new price and size on its side.
+ */
+OrderCommand OrderFlowGenerator::NextModify() {
+	LiveOrder& order = live_[std::uniform_int_distribution<std::size_t>(0, live_.size() - 1)(rng_)];
+
+	if (order.quantity_ > 1 && unit_(rng_) < config_.reduceShare_) {
+		order.quantity_ /= 2;
+	} else {
+		RemoveLivePrice(order.side_, order.price_);
+		order.price_ = NextPassivePrice(order.side_);
+		order.quantity_ = NextQuantity();
+		AddLivePrice(order.side_, order.price_);
+	}
+
+	return OrderCommand{ OrderCommandType::Modify, OrderType::GoodTillCancel, order.side_, config_.symbol_, order.orderId_, order.price_, order.quantity_ };
+}
+
+Side OrderFlowGenerator::NextSide() {
+	return unit_(rng_) < 0.5 ? Side::Buy : Side::Sell;
+}
+
+/* Draws a Pareto-distributed distance in ticks starting at zero, capped at maxTouchDistance_.
+ */
+Price OrderFlowGenerator::NextTouchDistance() {
+	const double distance = std::pow(1.0 - unit_(rng_), -1.0 / config_.touchDistanceAlpha_) - 1.0;
+	return static_cast<Price>(std::min(distance, static_cast<double>(config_.maxTouchDistance_)));
+}
+
+/* The touch sits one tick either side of the mid, and passive orders rest behind it without crossing the opposite side.
+ */
+Price OrderFlowGenerator::NextPassivePrice(Side side) {
+	const Price distance = NextTouchDistance();
+
+	if (side == Side::Buy) {
+		const Price price = mid_ - 1 - distance;
+		return askPrices_.empty() ? price : std::min(price, askPrices_.begin()->first - 1);
+	}
+
+	const Price price = mid_ + 1 + distance;
+	return bidPrices_.empty() ? price : std::max(price, bidPrices_.rbegin()->first + 1);
+}
+
+/* Prices through the best opposite order the generator has placed, or through the opposite touch if there is none.
+ */
+Price OrderFlowGenerator::NextMarketablePrice(Side side) {
+	const Price distance = NextTouchDistance();
+
+	if (side == Side::Buy)
+		return (askPrices_.empty() ? mid_ + 1 : askPrices_.begin()->first) + distance;
+
+	return (bidPrices_.empty() ? mid_ - 1 : bidPrices_.rbegin()->first) - distance;
+}
+
+Quantity OrderFlowGenerator::NextQuantity() {
+	const auto quantity = static_cast<Quantity>(std::llround(quantityDist_(rng_)));
+	return std::clamp<Quantity>(quantity, 1, config_.maxQuantity_);
+}
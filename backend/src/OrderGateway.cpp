@@ -0,0 +1,96 @@
+#include <array>
+#include <stdexcept>
+
+#include "OrderGateway.h"
+
+namespace {
+	// Empty polls spent spinning before the matching thread starts yielding its core.
+	constexpr std::size_t IDLE_SPIN_LIMIT = 1024;
+}
+
+template <typename Queue>
+BasicOrderGateway<Queue>::BasicOrderGateway(std::size_t capacity, ExecutionHandler handler)
+	: queue_{ capacity }
+	, handler_{ std::move(handler) }
+	, matchingThread_{ [this] { RunMatching(); } }
+{}
+
+template <typename Queue>
+BasicOrderGateway<Queue>::~BasicOrderGateway() {
+	Stop();
+}
+
+/* Queues the command for the matching thread, returning false if the ring buffer is full.
+ * Runs in O(1).
+ */
+template <typename Queue>
+bool BasicOrderGateway<Queue>::TrySubmit(const OrderCommand& command) {
+	if (stopping_.load(std::memory_order_relaxed))
+		throw std::logic_error("OrderGateway is stopped.");
+
+	return queue_.TryPush(command);
+}
+
+/* Queues the command for the matching thread, yielding while the ring buffer is full.
+ */
+template <typename Queue>
+void BasicOrderGateway<Queue>::Submit(const OrderCommand& command) {
+	while (!TrySubmit(command))
+		std::this_thread::yield();
+}
+
+/* Lets the matching thread drain every command submitted so far and joins it.
+ * Must not race with producers that are still submitting.
+ */
+template <typename Queue>
+void BasicOrderGateway<Queue>::Stop() {
+	if (stopping_.exchange(true, std::memory_order_release))
+		return;
+
+	matchingThread_.join();
+}
+
+/* Matching loop: drains the ring buffer in batches of up to DRAIN_BATCH_SIZE commands,
+ * spinning briefly and then yielding while it is empty.
+ */
+template <typename Queue>
+void BasicOrderGateway<Queue>::RunMatching() {
+	std::array<OrderCommand, DRAIN_BATCH_SIZE> batch;
+	Trades executed;
+	std::size_t idlePolls = 0;
+
+	while (true) {
+		std::size_t count = queue_.PopBatch(batch.data(), batch.size());
+
+		if (count == 0) {
+			if (!stopping_.load(std::memory_order_acquire)) {
+				if (++idlePolls > IDLE_SPIN_LIMIT)
+					std::this_thread::yield();
+
+				continue;
+			}
+
+			// Producers are done once stopping_ is set, so an empty poll after seeing it means everything was drained.
+			count = queue_.PopBatch(batch.data(), batch.size());
+			if (count == 0)
+				return;
+		}
+
+		idlePolls = 0;
+		std::size_t trades = 0;
+
+		for (std::size_t i = 0; i < count; ++i) {
+			ApplyOrderCommand(orderbook_, batch[i], executed);
+			trades += executed.size();
+
+			if (handler_)
+				handler_(batch[i], executed);
+		}
+
+		processed_.fetch_add(count, std::memory_order_relaxed);
+		trades_.fetch_add(trades, std::memory_order_relaxed);
+	}
+}
+
+template class BasicOrderGateway<MpscRingBuffer<OrderCommand>>;
+template class BasicOrderGateway<SpscRingBuffer<OrderCommand>>;
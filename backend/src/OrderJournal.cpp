@@ -0,0 +1,118 @@
+#include <format>
+#include <stdexcept>
+
+#include "OrderJournal.h"
+
+namespace {
+	template <typename T>
+	void Store(char*& out, T value) {
+		for (std::size_t i = 0; i < sizeof(T); ++i)
+			*out++ = static_cast<char>(static_cast<std::uint64_t>(value) >> (8 * i));
+	}
+
+	template <typename T>
+	T Load(const char*& in) {
+		std::uint64_t value = 0;
+		for (std::size_t i = 0; i < sizeof(T); ++i)
+			value |= static_cast<std::uint64_t>(static_cast<unsigned char>(*in++)) << (8 * i);
+
+		return static_cast<T>(value);
+	}
+}
+
+void OrderJournal::Encode(const JournalEntry& entry, char* record) {
+	const auto& command = entry.command_;
+
+	Store<std::uint64_t>(record, entry.timestamp_);
+	Store<std::uint8_t>(record, static_cast<std::uint8_t>(command.type_));
+	Store<std::uint8_t>(record, static_cast<std::uint8_t>(command.orderType_));
+	Store<std::uint8_t>(record, static_cast<std::uint8_t>(command.side_));
+	Store<std::uint8_t>(record, 0);
+	Store<std::uint32_t>(record, command.symbol_);
+	Store<std::uint64_t>(record, command.orderId_);
+	Store<std::uint64_t>(record, command.price_);
+	Store<std::uint64_t>(record, command.quantity_);
+}
+
+/* Rejects records whose enums are out of range, which is what a truncated or foreign file usually shows up as.
+ */
+JournalEntry OrderJournal::Decode(const char* record) {
+	JournalEntry entry{};
+	auto& command = entry.command_;
+
+	entry.timestamp_ = Load<std::uint64_t>(record);
+	const auto type = Load<std::uint8_t>(record);
+	const auto orderType = Load<std::uint8_t>(record);
+	const auto side = Load<std::uint8_t>(record);
+	Load<std::uint8_t>(record);
+	command.symbol_ = Load<std::uint32_t>(record);
+	command.orderId_ = Load<std::uint64_t>(record);
+	command.price_ = Load<std::uint64_t>(record);
+	command.quantity_ = Load<std::uint64_t>(record);
+
+	if (type > static_cast<std::uint8_t>(OrderCommandType::Modify) || orderType > static_cast<std::uint8_t>(OrderType::Market) ||
+		side > static_cast<std::uint8_t>(Side::Sell))
+		throw std::runtime_error(std::format("Journal record of order ({}) is corrupt.", command.orderId_));
+
+	command.type_ = static_cast<OrderCommandType>(type);
+	command.orderType_ = static_cast<OrderType>(orderType);
+	command.side_ = static_cast<Side>(side);
+
+	return entry;
+}
+
+OrderJournalWriter::OrderJournalWriter(const std::filesystem::path& path) : file_{ path, std::ios::binary | std::ios::trunc } {
+	if (!file_)
+		throw std::runtime_error(std::format("Journal ({}) cannot be opened for writing.", path.string()));
+
+	file_.write(OrderJournal::JOURNAL_MAGIC.data(), OrderJournal::JOURNAL_MAGIC.size());
+}
+
+void OrderJournalWriter::Write(const JournalEntry& entry) {
+	std::array<char, OrderJournal::RECORD_SIZE> record;
+	OrderJournal::Encode(entry, record.data());
+
+	file_.write(record.data(), record.size());
+}
+
+void OrderJournalWriter::Flush() {
+	file_.flush();
+
+	if (!file_)
+		throw std::runtime_error("Journal could not be written.");
+}
+
+OrderJournalReader::OrderJournalReader(const std::filesystem::path& path) : file_{ path, std::ios::binary } {
+	if (!file_)
+		throw std::runtime_error(std::format("Journal ({}) cannot be opened for reading.", path.string()));
+
+	std::array<char, OrderJournal::JOURNAL_MAGIC.size()> magic{};
+	file_.read(magic.data(), magic.size());
+
+	if (!file_ || magic != OrderJournal::JOURNAL_MAGIC)
+		throw std::runtime_error(std::format("File ({}) is not a journal of this version.", path.string()));
+}
+
+bool OrderJournalReader::Next(JournalEntry& entry) {
+	std::array<char, OrderJournal::RECORD_SIZE> record;
+	file_.read(record.data(), record.size());
+
+	if (file_.gcount() == 0)
+		return false;
+	if (static_cast<std::size_t>(file_.gcount()) != record.size())
+		throw std::runtime_error("Journal ends in the middle of a record.");
+
+	entry = OrderJournal::Decode(record.data());
+	return true;
+}
+
+JournalEntries OrderJournalReader::ReadAll(const std::filesystem::path& path) {
+	OrderJournalReader reader{ path };
+	JournalEntries entries;
+	JournalEntry entry;
+
+	while (reader.Next(entry))
+		entries.push_back(entry);
+
+	return entries;
+}
@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <numeric>
 #include <chrono>
 #include <ctime>
 #include <future>
+#include <limits>
 
 #include "Orderbook.h"
 
@@ -12,30 +14,36 @@ namespace {
 }
 
 // Strategy singletons
-const Orderbook::IOrderbookSnapshotStrategy& Orderbook::SequentialStrategy() {
+const OrderbookSnapshotStrategies::IOrderbookSnapshotStrategy& OrderbookSnapshotStrategies::SequentialStrategy() {
 	static SequentialSnapshot instance;
 	return instance;
 }
 
-const Orderbook::IOrderbookSnapshotStrategy& Orderbook::AsyncStrategy() {
+const OrderbookSnapshotStrategies::IOrderbookSnapshotStrategy& OrderbookSnapshotStrategies::AsyncStrategy() {
 	static AsyncSnapshot instance;
 	return instance;
 }
 
-const Orderbook::IOrderbookSnapshotStrategy& Orderbook::ThreadPoolStrategy() {
+const OrderbookSnapshotStrategies::IOrderbookSnapshotStrategy& OrderbookSnapshotStrategies::ThreadPoolStrategy() {
 	static ThreadPoolSnapshot instance;
 	return instance;
 }
 
-const Orderbook::IOrderbookSnapshotStrategy& Orderbook::AsyncThreadPoolStrategy() {
+const OrderbookSnapshotStrategies::IOrderbookSnapshotStrategy& OrderbookSnapshotStrategies::AsyncThreadPoolStrategy() {
 	static AsyncThreadPoolSnapshot instance;
 	return instance;
 }
 
+const OrderbookSnapshotStrategies::IOrderbookSnapshotStrategy& OrderbookSnapshotStrategies::AggregateStrategy() {
+	static AggregateSnapshot instance;
+	return instance;
+}
+
 /* Cancels GFD orders at the end of a trading day (4PM).
  * Runs in O(N * log(M)). 
  */
-void Orderbook::PruneGoodForDayOrders() {
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::PruneGoodForDayOrders() {
 	using namespace std::chrono;
 	const auto end = hours(MARKET_END_HOUR);
 
@@ -44,7 +52,11 @@ void Orderbook::PruneGoodForDayOrders() {
 		const auto now = system_clock::now();
 		const auto now_c = system_clock::to_time_t(now);
 		std::tm now_parts;
+#if defined(_WIN32)
 		localtime_s(&now_parts, &now_c);
+#else
+		localtime_r(&now_c, &now_parts);
+#endif
 
 		if (now_parts.tm_hour >= end.count())
 			now_parts.tm_mday += 1;
@@ -69,120 +81,199 @@ void Orderbook::PruneGoodForDayOrders() {
 		{
 			std::scoped_lock ordersLock{ ordersMutex_ };
 
-			for (const auto& [_, entry] : orders_) {
-				const auto& [order, _] = entry;
-
-				if (order->GetOrderType() != OrderType::GoodForDay)
-					continue;
-
-				orderIds.push_back(order->GetOrderId());
-			}
+			orders_.ForEach([&orderIds](const Order& order) {
+				if (order.GetOrderType() == OrderType::GoodForDay)
+					orderIds.push_back(order.GetOrderId());
+			});
 		}
 
 		CancelOrders(orderIds);
 	}
 }
 
-/* Cancels all orders with the given order ids.
- * Runs in O(N * log(M)), where:
+/* Acquires a lock on the orders once and then cancels all orders with the given order ids.
+ * The cancels are applied level by level, best first, so each price level is touched while it is hot in cache.
+ * Unknown order ids are skipped.
+ * Runs in O(N * log(N) + N * log(M)), where:
  * - N = amount of given order ids and
  * - M = number of distinct price levels.
  */
-void Orderbook::CancelOrders(OrderIds orderIds) {
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::CancelOrders(std::span<const OrderId> orderIds) {
+	NullExecutionSink sink;
+	CancelOrders(orderIds, sink);
+}
+
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::CancelOrders(std::span<const OrderId> orderIds, IExecutionSink& sink) {
 	std::scoped_lock ordersLock{ ordersMutex_ };
 
-	for (const auto& orderId : orderIds)
-		CancelOrderInternal(orderId);
+	struct PendingCancel {
+		Side side_;
+		Price price_;
+		OrderId orderId_;
+	};
+
+	std::vector<PendingCancel> cancels;
+	cancels.reserve(orderIds.size());
+
+	for (const auto& orderId : orderIds) {
+		if (const Order* order = orders_.Find(orderId))
+			cancels.push_back({ order->GetSide(), order->GetPrice(), orderId });
+	}
+
+	std::sort(cancels.begin(), cancels.end(), [](const PendingCancel& lhs, const PendingCancel& rhs) {
+		if (lhs.side_ != rhs.side_)
+			return lhs.side_ < rhs.side_;
+
+		return lhs.side_ == Side::Buy ? lhs.price_ > rhs.price_ : lhs.price_ < rhs.price_;
+	});
+
+	// An id listed twice is simply not found the second time.
+	for (const auto& cancel : cancels)
+		CancelOrderInternal(cancel.orderId_, sink);
+
+	Publish();
 }
 
 /* Cancels the order with the given order id.
  * Runs in O(log(M)) where M is the number of distinct price levels.
  */
-void Orderbook::CancelOrderInternal(OrderId orderId) {
-	if (!orders_.contains(orderId)) return;
-
-	const auto [order, iterator] = orders_.at(orderId);
-	orders_.erase(orderId);
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::CancelOrderInternal(OrderId orderId, IExecutionSink& sink) {
+	Order* order = orders_.Erase(orderId);
+	if (!order) return;
 
 	if (order->GetSide() == Side::Sell) {
 		auto price = order->GetPrice();
 		auto& orders = asks_.at(price);
 
-		orders.erase(iterator);
+		orders.erase(*order);
 		if (orders.empty()) asks_.erase(price);
 	} else {
 		auto price = order->GetPrice();
 		auto& orders = bids_.at(price);
 
-		orders.erase(iterator);
+		orders.erase(*order);
 		if (orders.empty()) bids_.erase(price);
 	}
 
-	OnOrderCancelled(order);
+	OnOrderCancelled(*order, sink);
+	pool_.Release(order);
 }
 
-void Orderbook::OnOrderCancelled(OrderPointer order) {
-	UpdateLevelData(order->GetPrice(), order->GetRemainingQuantity(), LevelData::Action::Remove);
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::OnOrderCancelled(const Order& order, IExecutionSink& sink) {
+	UpdateLevelData(order.GetSide(), order.GetPrice(), order.GetRemainingQuantity(), LevelData::Action::Remove, sink);
+	sink.OnOrderCancelled(order.GetOrderId(), order.GetRemainingQuantity());
 }
 
-void Orderbook::OnOrderAdded(OrderPointer order) {
-	UpdateLevelData(order->GetPrice(), order->GetInitialQuantity(), LevelData::Action::Add);
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::OnOrderAdded(const Order& order, IExecutionSink& sink) {
+	UpdateLevelData(order.GetSide(), order.GetPrice(), order.GetRemainingQuantity(), LevelData::Action::Add, sink);
 }
 
-void Orderbook::OnOrderMatched(Price price, Quantity quantity, bool isFullyFilled) {
-	UpdateLevelData(price, quantity, isFullyFilled ? LevelData::Action::Remove : LevelData::Action::Match);
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::OnOrderMatched(Side side, Price price, Quantity quantity, bool isFullyFilled, IExecutionSink& sink) {
+	UpdateLevelData(side, price, quantity, isFullyFilled ? LevelData::Action::Remove : LevelData::Action::Match, sink);
 }
 
-/* Updates level data corresponding to the given price and quantity based on the given action.
- * Runs in amortized O(1).
+/* Updates level data corresponding to the given price and quantity based on the given action,
+ * keeps the cumulative depth index of the given side in sync and reports the new level quantity to the sink.
+ * Runs in amortized O(log L) where L is the amount of levels in the depth index.
  */
-void Orderbook::UpdateLevelData(Price price, Quantity quantity, LevelData::Action action) {
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::UpdateLevelData(Side side, Price price, Quantity quantity, LevelData::Action action, IExecutionSink& sink) {
 	auto& data = data_[price];
 
 	data.count_ += action == LevelData::Action::Remove ? -1 : action == LevelData::Action::Add ? 1 : 0;
 
 	if (action == LevelData::Action::Remove || action == LevelData::Action::Match) {
 		data.quantity_ -= quantity;
+		depthIndex_.Remove(side, price, quantity);
 	} else {
 		data.quantity_ += quantity;
+		depthIndex_.Add(side, price, quantity);
 	}
 
-	if (data.count_ == 0) data_.erase(price);
+	sink.OnLevelChanged(side, price, data.quantity_);
+
+	if (data.count_ == 0) {
+		data_.erase(price);
+
+		// An index that gave up on a price span too wide for it starts over once the book is empty.
+		if (data_.empty() && !depthIndex_.IsActive())
+			depthIndex_ = CumulativeDepthIndex{};
+	}
 }
 
-/* Checks if an order with the given side, price, and quantity can be fully filled.
- * Runs in O(N), where N is the amount of price levels. 
+/* Checks if an order with the given side, price, and quantity can be fully filled,
+ * by asking the cumulative depth index how much opposite quantity sits between the best price and the limit price,
+ * or by walking the opposite side while the index is inactive.
+ * Runs in O(log L) where L is the amount of levels in the depth index, or O(K) where K is the amount of levels walked.
  */
-bool Orderbook::CanFullyFill(Side side, Price price, Quantity quantity) const {
+template <typename LockPolicy>
+bool BasicOrderbook<LockPolicy>::CanFullyFill(Side side, Price price, Quantity quantity) const {
 	if (!CanMatch(side, price)) return false;
 
-	std::optional<Price> threshold;
+	const Side opposite = side == Side::Buy ? Side::Sell : Side::Buy;
 
-	if (side == Side::Buy) {
-		const auto [askPrice, _] = *asks_.begin();
-		threshold = askPrice;
-	} else {
-		const auto [bidPrice, _] = *bids_.begin();
-		threshold = bidPrice;
-	}
+	if (!depthIndex_.IsActive())
+		return WalkQuantityUpTo(opposite, price, quantity) >= quantity;
 
-	for (const auto& [levelPrice, levelData] : data_) {
-		if (threshold.has_value() &&
-			(side == Side::Buy && threshold.value() > levelPrice) ||
-			(side == Side::Sell && threshold.value() < levelPrice))
-			continue;
+	return depthIndex_.QuantityUpTo(opposite, price) >= quantity;
+}
 
-		if ((side == Side::Buy && levelPrice > price) ||
-			(side == Side::Sell && levelPrice < price))
-			continue;
+/* Sums the maintained level quantities of the given side from its best price up to the given price, inclusive,
+ * stopping early once the sum reaches the given limit.
+ * Runs in O(K) where K is the amount of levels walked.
+ */
+template <typename LockPolicy>
+Quantity BasicOrderbook<LockPolicy>::WalkQuantityUpTo(Side side, Price price, Quantity limit) const {
+	auto walk = [&](const auto& levels, auto isWithinLimit) {
+		Quantity total = 0;
 
-		if (quantity <= levelData.quantity_)
-			return true;
+		for (const auto& [levelPrice, _] : levels) {
+			if (total >= limit || !isWithinLimit(levelPrice))
+				break;
 
-		quantity -= levelData.quantity_;
-	}
+			total += data_.at(levelPrice).quantity_;
+		}
 
-	return false;
+		return total;
+	};
+
+	if (side == Side::Buy)
+		return walk(bids_, [price](Price bidPrice) { return bidPrice >= price; });
+
+	return walk(asks_, [price](Price askPrice) { return askPrice <= price; });
+}
+
+/* Walks the given side from its best price until the maintained level quantities add up to the given quantity.
+ * Runs in O(K) where K is the amount of levels walked.
+ */
+template <typename LockPolicy>
+std::optional<Price> BasicOrderbook<LockPolicy>::WalkPriceForQuantity(Side side, Quantity quantity) const {
+	if (quantity == 0)
+		return std::nullopt;
+
+	auto walk = [&](const auto& levels) -> std::optional<Price> {
+		for (const auto& [levelPrice, _] : levels) {
+			const Quantity available = data_.at(levelPrice).quantity_;
+
+			if (quantity <= available)
+				return levelPrice;
+
+			quantity -= available;
+		}
+
+		return std::nullopt;
+	};
+
+	if (side == Side::Buy)
+		return walk(bids_);
+
+	return walk(asks_);
 }
 
 /* Returns true if an order on the given side and price can be matched against the best available opposite order.
@@ -190,7 +281,8 @@ bool Orderbook::CanFullyFill(Side side, Price price, Quantity quantity) const {
  * For a sell order, checks if it can match the best bid.
  * Runs in O(1).
  */
-bool Orderbook::CanMatch(Side side, Price price) const {
+template <typename LockPolicy>
+bool BasicOrderbook<LockPolicy>::CanMatch(Side side, Price price) const {
 	if (side == Side::Buy) {
 		if (asks_.empty())
 			return false;
@@ -206,191 +298,392 @@ bool Orderbook::CanMatch(Side side, Price price) const {
 	}
 }
 
-/* Matches orders in the orderbook.
- * Runs in O(N * log(M)) where N is the total amount of orders and M is the amount of price levels.
+/* Matches the incoming order against the opposite side, best level first, reporting every trade to the sink.
+ * Only the incoming order can cross, so the rest of the book is never revisited. Market orders have no limit and
+ * trade at the price of each level they reach.
+ * Runs in O(F + E * log(M)) where F is the amount of resting orders filled, E the amount of levels emptied
+ * and M the amount of price levels.
  */
-Trades Orderbook::MatchOrders() {
-	Trades trades;
-	trades.reserve(orders_.size());
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::MatchOrder(Order& order, IExecutionSink& sink) {
+	const bool isBuy = order.GetSide() == Side::Buy;
+	const bool isMarket = order.GetOrderType() == OrderType::Market;
 
-	while (true) {
-		if (bids_.empty() || asks_.empty())
-			break;
+	auto match = [&](auto& levels) {
+		while (!order.IsFilled() && !levels.empty()) {
+			auto level = levels.begin();
+			auto& [price, orders] = *level;
 
-		auto& [bidPrice, bids] = *bids_.begin();
-		auto& [askPrice, asks] = *asks_.begin();
+			if (!isMarket && (isBuy ? price > order.GetPrice() : price < order.GetPrice()))
+				break;
 
-		if (bidPrice < askPrice)
-			break;
+			while (!order.IsFilled() && !orders.empty()) {
+				Order& resting = orders.front();
+				const Quantity quantity = std::min(order.GetRemainingQuantity(), resting.GetRemainingQuantity());
 
-		while (bids.size() && asks.size()) {
-			auto bid = bids.front();
-			auto ask = asks.front();
+				order.Fill(quantity);
+				resting.Fill(quantity);
 
-			Quantity quantity = std::min(bid->GetRemainingQuantity(), ask->GetRemainingQuantity());
+				const TradeInfo aggressorTrade{ order.GetOrderId(), isMarket ? price : order.GetPrice(), quantity };
+				const TradeInfo restingTrade{ resting.GetOrderId(), resting.GetPrice(), quantity };
+				sink.OnTrade(isBuy ? Trade{ aggressorTrade, restingTrade } : Trade{ restingTrade, aggressorTrade });
 
-			bid->Fill(quantity);
-			ask->Fill(quantity);
+				OnOrderMatched(resting.GetSide(), price, quantity, resting.IsFilled(), sink);
 
-			if (bid->IsFilled()) {
-				bids.pop_front();
-				orders_.erase(bid->GetOrderId());
+				if (resting.IsFilled()) {
+					orders.pop_front();
+					orders_.Erase(resting.GetOrderId());
+					pool_.Release(&resting);
+				}
 			}
 
-			if (ask->IsFilled()) {
-				asks.pop_front();
-				orders_.erase(ask->GetOrderId());
-			}
+			if (orders.empty())
+				levels.erase(level);
+		}
+	};
 
-			trades.push_back(Trade{
-				TradeInfo{ bid->GetOrderId(), bid->GetPrice(), quantity },
-				TradeInfo{ ask->GetOrderId(), ask->GetPrice(), quantity }
-			});
+	if (isBuy)
+		match(asks_);
+	else
+		match(bids_);
+}
 
-			OnOrderMatched(bid->GetPrice(), quantity, bid->IsFilled());
-			OnOrderMatched(ask->GetPrice(), quantity, ask->IsFilled());
-		}
+/* Validates, matches and rests the order, reporting what happens to it to the sink.
+ * Quantity that a FillAndKill or Market order leaves unfilled is reported as cancelled.
+ * Must be called with the ordersMutex_ held; the caller publishes once it is done.
+ * Runs in O(F + E * log(M)) for the matching part, plus O(log(M)) when the order rests.
+ */
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::AddOrderInternal(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity, IExecutionSink& sink) {
+	if (orders_.Contains(orderId))
+		return;
 
-		if (bids.empty()) {
-			bids_.erase(bidPrice);
-			data_.erase(bidPrice);
-		}
+	if (orderType == OrderType::FillAndKill && !CanMatch(side, price))
+		return;
 
-		if (asks.empty()) {
-			asks_.erase(askPrice);
-			data_.erase(askPrice);
-		}
-	}
+	if (orderType == OrderType::FillOrKill && !CanFullyFill(side, price, quantity))
+		return;
 
-	if (!bids_.empty()) {
-		auto& [_, bids] = *bids_.begin();
-		auto& order = bids.front();
-		if (order->GetOrderType() == OrderType::FillAndKill)
-			CancelOrder(order->GetOrderId());
-	}
+	sink.OnOrderAccepted(orderId, side, price, quantity);
+
+	// Market orders sweep the opposite side and never rest, whatever is left once the side runs dry is dropped.
+	Order order = orderType == OrderType::Market ? Order{ orderId, side, quantity } : Order{ orderType, orderId, side, price, quantity };
+	MatchOrder(order, sink);
 
-	if (!asks_.empty()) {
-		auto& [_, asks] = *asks_.begin();
-		auto& order = asks.front();
-		if (order->GetOrderType() == OrderType::FillAndKill)
-			CancelOrder(order->GetOrderId());
+	if (order.IsFilled())
+		return;
+
+	if (orderType == OrderType::FillAndKill || orderType == OrderType::Market) {
+		sink.OnOrderCancelled(orderId, order.GetRemainingQuantity());
+		return;
 	}
 
-	return trades;
+	Order& resting = *pool_.Acquire(order);
+
+	if (side == Side::Buy)
+		bids_[price].push_back(resting);
+	else
+		asks_[price].push_back(resting);
+
+	orders_.Insert(resting);
+
+	OnOrderAdded(resting, sink);
 }
 
-//Orderbook::Orderbook() : ordersPruneThread_{ [this] { PruneGoodForDayOrders(); } } {}
-Orderbook::Orderbook() {}
+//template <typename LockPolicy>
+//BasicOrderbook<LockPolicy>::BasicOrderbook() : ordersPruneThread_{ [this] { PruneGoodForDayOrders(); } } {}
+template <typename LockPolicy>
+BasicOrderbook<LockPolicy>::BasicOrderbook() {}
+
+template <typename LockPolicy>
+BasicOrderbook<LockPolicy>::BasicOrderbook(OrderIndexMode indexMode) : orders_{ indexMode } {}
 
-//Orderbook::~Orderbook() {
+/* Pre-sizes the order pool and the order index for the given amount of live orders,
+ * so that filling the book up to that size doesn't grow either of them.
+ * OrderIndexMode::Dense suits venues that assign order ids sequentially, see OrderIdIndex.
+ */
+template <typename LockPolicy>
+BasicOrderbook<LockPolicy>::BasicOrderbook(std::size_t orderCapacity, OrderIndexMode indexMode)
+	: pool_{ orderCapacity }
+	, orders_{ indexMode }
+{
+	orders_.reserve(orderCapacity);
+}
+
+//template <typename LockPolicy>
+//BasicOrderbook<LockPolicy>::~BasicOrderbook() {
 //	shutdown_.store(true, std::memory_order_release);
 //	shutdownConditionVariable_.notify_one();
 //	ordersPruneThread_.join();
 //}
-Orderbook::~Orderbook() {}
+template <typename LockPolicy>
+BasicOrderbook<LockPolicy>::~BasicOrderbook() {}
 
-/* Adds an order to the orderbook.
+/* Adds a copy of the given order to the orderbook.
  * Runs in O(N * log(M)) where N is the total amount of orders and M is the amount of price levels.
  */
-Trades Orderbook::AddOrder(OrderPointer order) {
-	std::scoped_lock ordersLock{ ordersMutex_ };
+template <typename LockPolicy>
+Trades BasicOrderbook<LockPolicy>::AddOrder(OrderPointer order) {
+	return AddOrder(order->GetOrderType(), order->GetOrderId(), order->GetSide(), order->GetPrice(), order->GetRemainingQuantity());
+}
 
-	if (orders_.contains(order->GetOrderId()))
-		return {};
-
-	if (order->GetOrderType() == OrderType::FillAndKill && !CanMatch(order->GetSide(), order->GetPrice()))
-		return {};
-
-	if (order->GetOrderType() == OrderType::Market) {
-		if (order->GetSide() == Side::Buy && !asks_.empty()) {
-			const auto& [worstAsk, _] = *asks_.rbegin();
-			order->ToGoodTillCancel(worstAsk);
-		} else if (order->GetSide() == Side::Sell && !bids_.empty()) {
-			const auto& [worstBid, _] = *bids_.rbegin();
-			order->ToGoodTillCancel(worstBid);
-		} else
-			return {};
-	}
+/* Adds an order to the orderbook and returns the trades it caused.
+ * Thin adapter over the IExecutionSink overload that collects the trades into a new vector.
+ * Runs in O(F + E * log(M)) where F is the amount of resting orders filled, E the amount of levels emptied
+ * and M the amount of price levels.
+ */
+template <typename LockPolicy>
+Trades BasicOrderbook<LockPolicy>::AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity) {
+	Trades trades;
+	TradesExecutionSink sink{ trades };
+	AddOrder(orderType, orderId, side, price, quantity, sink);
 
-	if (order->GetOrderType() == OrderType::FillOrKill && !CanFullyFill(order->GetSide(), order->GetPrice(), order->GetInitialQuantity()))
-		return {};
+	return trades;
+}
 
-	OrderPointers::iterator iterator;
+/* Adds the order, writing its trades into the caller-owned buffer.
+ * The buffer is cleared first, so a caller reusing it across orders stops allocating once it has grown to fit.
+ * Runs in O(F + E * log(M)) where F is the amount of resting orders filled, E the amount of levels emptied
+ * and M the amount of price levels.
+ */
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity, Trades& trades) {
+	trades.clear();
 
-	if (order->GetSide() == Side::Buy) {
-		auto& orders = bids_[order->GetPrice()];
-		orders.push_back(order);
-		iterator = std::prev(orders.end());
-	} else {
-		auto& orders = asks_[order->GetPrice()];
-		orders.push_back(order);
-		iterator = std::prev(orders.end());
-	}
+	TradesExecutionSink sink{ trades };
+	AddOrder(orderType, orderId, side, price, quantity, sink);
+}
 
-	orders_.insert({ order->GetOrderId(), OrderEntry{ order, iterator } });
+/* Acquires a lock on the orders and then adds the order, streaming its acceptance, trades, level changes
+ * and any unfilled remainder it drops to the sink without allocating.
+ * Runs in O(F + E * log(M)) where F is the amount of resting orders filled, E the amount of levels emptied
+ * and M the amount of price levels.
+ */
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity, IExecutionSink& sink) {
+	std::scoped_lock ordersLock{ ordersMutex_ };
 
-	OnOrderAdded(order);
+	AddOrderInternal(orderType, orderId, side, price, quantity, sink);
+	Publish();
+}
 
-	return MatchOrders();
+/* Acquires a lock on the orders once and then adds the given orders in sequence, returning all the trades they caused.
+ * Only the add fields of each command are read. The orders keep their arrival order, since sorting them would break
+ * price-time priority between orders of the same batch.
+ * Runs in O(B * (F + E * log(M))) where B is the batch size and F, E and M are as for a single add.
+ */
+template <typename LockPolicy>
+Trades BasicOrderbook<LockPolicy>::AddOrders(std::span<const OrderCommand> orders) {
+	Trades trades;
+	TradesExecutionSink sink{ trades };
+	AddOrders(orders, sink);
+
+	return trades;
+}
+
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::AddOrders(std::span<const OrderCommand> orders, IExecutionSink& sink) {
+	std::scoped_lock ordersLock{ ordersMutex_ };
+
+	for (const auto& order : orders)
+		AddOrderInternal(order.orderType_, order.orderId_, order.side_, order.price_, order.quantity_, sink);
+
+	Publish();
 }
 
 /* Acquires a lock on the orders and then cancels the order with the given order id.
  * Runs in O(log(M)) where M is the number of distinct price levels.
  */
-void Orderbook::CancelOrder(OrderId orderId) {
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::CancelOrder(OrderId orderId) {
+	NullExecutionSink sink;
+	CancelOrder(orderId, sink);
+}
+
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::CancelOrder(OrderId orderId, IExecutionSink& sink) {
 	std::scoped_lock ordersLock{ ordersMutex_ };
 
-	CancelOrderInternal(orderId);
+	CancelOrderInternal(orderId, sink);
+	Publish();
 }
 
-/* Modifies the order with the given order id by first cancelling the order, and then adding a new order with the modified data.
- * Runs in O(N * log(M)) where N is the total amount of orders and M is the amount of price levels.
+/* Modifies the order with the given order id under a single lock. A reduction that keeps the side and price lowers the
+ * quantity in place and keeps the order's queue position; any other change cancels the order and adds it again at the
+ * back of its new level.
+ * Runs in O(1) for an in-place reduction, otherwise as a cancel plus an add.
  */
-Trades Orderbook::ModifyOrder(OrderModify order) {
-	OrderType orderType;
+template <typename LockPolicy>
+Trades BasicOrderbook<LockPolicy>::ModifyOrder(OrderModify order) {
+	Trades trades;
+	TradesExecutionSink sink{ trades };
+	ModifyOrder(order, sink);
+
+	return trades;
+}
+
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::ModifyOrder(OrderModify order, IExecutionSink& sink) {
+	std::scoped_lock ordersLock{ ordersMutex_ };
 
-	{
-		std::scoped_lock ordersLock{ ordersMutex_ };
+	Order* found = orders_.Find(order.GetOrderId());
+	if (!found)
+		return;
 
-		if (!orders_.contains(order.GetOrderId()))
-			return {};
+	Order& existing = *found;
 
-		const auto& [existingOrder, _] = orders_.at(order.GetOrderId());
-		orderType = existingOrder->GetOrderType();
+	if (existing.GetSide() == order.GetSide() && existing.GetPrice() == order.GetPrice() &&
+		order.GetQuantity() > 0 && order.GetQuantity() <= existing.GetRemainingQuantity()) {
+		const Quantity reduction = existing.GetRemainingQuantity() - order.GetQuantity();
+
+		if (reduction > 0) {
+			existing.ReduceQuantity(reduction);
+			UpdateLevelData(existing.GetSide(), existing.GetPrice(), reduction, LevelData::Action::Match, sink);
+			Publish();
+		}
+
+		return;
 	}
 
-	CancelOrder(order.GetOrderId());
-	return AddOrder(order.ToOrderPointer(orderType));
+	const OrderType orderType = existing.GetOrderType();
+
+	CancelOrderInternal(order.GetOrderId(), sink);
+	AddOrderInternal(orderType, order.GetOrderId(), order.GetSide(), order.GetPrice(), order.GetQuantity(), sink);
+	Publish();
+}
+
+/* Returns the quantity resting on the given side between its best price and the given price, inclusive.
+ * Runs in O(log L) where L is the amount of levels in the depth index, or O(K) where K is the amount of levels walked
+ * while the index is inactive.
+ */
+template <typename LockPolicy>
+Quantity BasicOrderbook<LockPolicy>::QuantityUpTo(Side side, Price price) const {
+	std::scoped_lock ordersLock{ ordersMutex_ };
+
+	if (!depthIndex_.IsActive())
+		return WalkQuantityUpTo(side, price, std::numeric_limits<Quantity>::max());
+
+	return depthIndex_.QuantityUpTo(side, price);
+}
+
+/* Returns the worst price on the given side that an order sweeping the given quantity would reach,
+ * or nothing if the side doesn't hold that much.
+ * Runs in O(log L) where L is the amount of levels in the depth index, or O(K) where K is the amount of levels walked
+ * while the index is inactive.
+ */
+template <typename LockPolicy>
+std::optional<Price> BasicOrderbook<LockPolicy>::PriceForQuantity(Side side, Quantity quantity) const {
+	std::scoped_lock ordersLock{ ordersMutex_ };
+
+	if (!depthIndex_.IsActive())
+		return WalkPriceForQuantity(side, quantity);
+
+	return depthIndex_.PriceForQuantity(side, quantity);
 }
 
 /* Returns the size of the orderbook, i.e. the amount of orders.
  * Runs in O(1).
  */
-std::size_t Orderbook::Size() const {
+template <typename LockPolicy>
+std::size_t BasicOrderbook<LockPolicy>::Size() const {
 	std::scoped_lock ordersLock{ ordersMutex_ };
 	return orders_.size();
 }
 
 /* Generates a snapshot of the aggregated orderbook based on the selected strategy.
+ * The snapshot reads the book without locking, so it must run on the thread that mutates the book;
+ * other threads should read the published snapshot instead.
  */
-OrderbookLevelInfos Orderbook::GetOrderInfos(const IOrderbookSnapshotStrategy& strategy) const {
-	return strategy.Generate(bids_, asks_);
+template <typename LockPolicy>
+OrderbookLevelInfos BasicOrderbook<LockPolicy>::GetOrderInfos(const IOrderbookSnapshotStrategy& strategy) const {
+	return strategy.Generate(bids_, asks_, data_);
 }
 
-OrderbookLevelInfos Orderbook::GetOrderInfos(const IOrderbookSnapshotStrategy& strategy, ThreadPool& pool) const {
+template <typename LockPolicy>
+OrderbookLevelInfos BasicOrderbook<LockPolicy>::GetOrderInfos(const IOrderbookSnapshotStrategy& strategy, ThreadPool& pool) const {
 	return strategy.Generate(bids_, asks_, pool);
 }
 
+template <typename LockPolicy>
+OrderbookLevelInfos BasicOrderbook<LockPolicy>::GetOrderInfos(const IOrderbookSnapshotStrategy& strategy, WorkStealingThreadPool& pool) const {
+	return strategy.Generate(bids_, asks_, pool);
+}
+
+/* Writes the best depth levels of each side into the given caller-owned snapshot, reading the maintained level data.
+ * Runs in O(D) where D is the requested depth, independent of the size of the book.
+ */
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::GetOrderInfos(std::size_t depth, OrderbookDepthInfos& infos) const {
+	GetOrderInfos(AggregateStrategy(), depth, infos);
+}
+
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::GetOrderInfos(const IOrderbookSnapshotStrategy& strategy, std::size_t depth, OrderbookDepthInfos& infos) const {
+	strategy.Generate(bids_, asks_, data_, std::min(depth, OrderbookDepthInfos::MAX_DEPTH), infos);
+}
+
+/* Sets the amount of levels per side published after every add, cancel and modify, capped at OrderbookDepthInfos::MAX_DEPTH.
+ * A depth of zero (the default) disables publication.
+ */
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::SetPublishDepth(std::size_t depth) {
+	std::scoped_lock ordersLock{ ordersMutex_ };
+
+	publishDepth_ = std::min(depth, OrderbookDepthInfos::MAX_DEPTH);
+	Publish();
+}
+
+/* Returns a copy of the snapshot published by the last mutating call. Never blocks the matching thread,
+ * so any number of reader threads can call it concurrently with AddOrder, CancelOrder and ModifyOrder.
+ * Runs in O(1).
+ */
+template <typename LockPolicy>
+OrderbookDepthInfos BasicOrderbook<LockPolicy>::GetPublishedOrderInfos() const {
+	return published_.Load();
+}
+
+/* Publishes the best levels of each side for readers on other threads. Must be called with the ordersMutex_ held.
+ * Runs in O(D) where D is the publish depth.
+ */
+template <typename LockPolicy>
+void BasicOrderbook<LockPolicy>::Publish() {
+	if (publishDepth_ == 0) return;
+
+	OrderbookDepthInfos infos;
+	GetOrderInfos(publishDepth_, infos);
+	published_.Store(infos);
+}
+
+/* Generates a snapshot of the best depth levels of each side by summing the orders of those levels only.
+ * Runs in O(D * K) where D is the requested depth and K is the amount of orders per level.
+ */
+void OrderbookSnapshotStrategies::IOrderbookSnapshotStrategy::Generate(const BidMap& bids, const AskMap& asks, const LevelDataMap& levels, std::size_t depth, OrderbookDepthInfos& infos) const {
+	auto LevelQuantity = [](const OrderQueue& orders) {
+		Quantity total = 0;
+		for (const auto& order : orders)
+			total += order.GetRemainingQuantity();
+		return total;
+	};
+
+	infos.Clear();
+
+	for (auto it = bids.begin(); it != bids.end() && infos.GetBids().size() < depth; ++it)
+		infos.PushBid(LevelInfo{ it->first, LevelQuantity(it->second) });
+
+	for (auto it = asks.begin(); it != asks.end() && infos.GetAsks().size() < depth; ++it)
+		infos.PushAsk(LevelInfo{ it->first, LevelQuantity(it->second) });
+}
+
 /* Generates a snapshot of the aggregated orderbook, summarizing the total quantity at each price level for both bids and asks.
  * Runs in O(N) where N is the total amount of orders.
  */
-OrderbookLevelInfos Orderbook::SequentialSnapshot::Generate(const BidMap& bids, const AskMap& asks) const {
+OrderbookLevelInfos OrderbookSnapshotStrategies::SequentialSnapshot::Generate(const BidMap& bids, const AskMap& asks) const {
 	LevelInfos bidInfos;
 	bidInfos.reserve(bids.size());
 	for (const auto& [price, orderList] : bids) {
 		Quantity total = 0;
 		for (const auto& order : orderList)
-			total += order->GetRemainingQuantity();
+			total += order.GetRemainingQuantity();
 		bidInfos.push_back(LevelInfo{ price, total });
 	}
 
@@ -399,7 +692,7 @@ OrderbookLevelInfos Orderbook::SequentialSnapshot::Generate(const BidMap& bids,
 	for (const auto& [price, orderList] : asks) {
 		Quantity total = 0;
 		for (const auto& order : orderList)
-			total += order->GetRemainingQuantity();
+			total += order.GetRemainingQuantity();
 		askInfos.push_back(LevelInfo{ price, total });
 	}
 
@@ -409,11 +702,11 @@ OrderbookLevelInfos Orderbook::SequentialSnapshot::Generate(const BidMap& bids,
 /* Generates a snapshot of the aggregated orderbook, with the bids and asks being retrieved concurrently using async/futures.
  * Runs in O(N) where N is the total amount of orders.
  */
-OrderbookLevelInfos Orderbook::AsyncSnapshot::Generate(const BidMap& bids, const AskMap& asks) const {
-	auto CreateLevelInfos = [](Price price, const OrderPointers& orders) {
+OrderbookLevelInfos OrderbookSnapshotStrategies::AsyncSnapshot::Generate(const BidMap& bids, const AskMap& asks) const {
+	auto CreateLevelInfos = [](Price price, const OrderQueue& orders) {
 		return LevelInfo{ price, std::accumulate(orders.begin(), orders.end(), (Quantity)0,
-			[](Quantity runningSum, const OrderPointer& order)
-			{ return runningSum + order->GetRemainingQuantity(); })
+			[](Quantity runningSum, const Order& order)
+			{ return runningSum + order.GetRemainingQuantity(); })
 		};
 	};
 
@@ -444,11 +737,11 @@ OrderbookLevelInfos Orderbook::AsyncSnapshot::Generate(const BidMap& bids, const
 /* Generates a snapshot of the aggregated orderbook, with the bids and asks being retrieved concurrently using a thread pool.
  * Runs in O(N) where N is the total amount of orders.
  */
-OrderbookLevelInfos Orderbook::ThreadPoolSnapshot::Generate(const BidMap& bids, const AskMap& asks, ThreadPool& pool) const {
-	auto CreateLevelInfos = [](Price price, const OrderPointers& orders) {
+OrderbookLevelInfos OrderbookSnapshotStrategies::ThreadPoolSnapshot::Generate(const BidMap& bids, const AskMap& asks, ThreadPool& pool) const {
+	auto CreateLevelInfos = [](Price price, const OrderQueue& orders) {
 		return LevelInfo{ price, std::accumulate(orders.begin(), orders.end(), (Quantity)0,
-			[](Quantity runningSum, const OrderPointer& order)
-			{ return runningSum + order->GetRemainingQuantity(); })
+			[](Quantity runningSum, const Order& order)
+			{ return runningSum + order.GetRemainingQuantity(); })
 		};
 	};
 
@@ -499,11 +792,11 @@ OrderbookLevelInfos Orderbook::ThreadPoolSnapshot::Generate(const BidMap& bids,
 /* Generates a snapshot of the aggregated orderbook, with the bids and asks being retrieved concurrently using async/futures and a thread pool.
  * Runs in O(N) where N is the total amount of orders.
  */
-OrderbookLevelInfos Orderbook::AsyncThreadPoolSnapshot::Generate(const BidMap& bids, const AskMap& asks, ThreadPool& pool) const {
-	auto CreateLevelInfos = [](Price price, const OrderPointers& orders) {
+OrderbookLevelInfos OrderbookSnapshotStrategies::AsyncThreadPoolSnapshot::Generate(const BidMap& bids, const AskMap& asks, ThreadPool& pool) const {
+	auto CreateLevelInfos = [](Price price, const OrderQueue& orders) {
 		return LevelInfo{ price, std::accumulate(orders.begin(), orders.end(), (Quantity)0,
-			[](Quantity runningSum, const OrderPointer& order)
-			{ return runningSum + order->GetRemainingQuantity(); })
+			[](Quantity runningSum, const Order& order)
+			{ return runningSum + order.GetRemainingQuantity(); })
 		};
 	};
 
@@ -511,7 +804,7 @@ OrderbookLevelInfos Orderbook::AsyncThreadPoolSnapshot::Generate(const BidMap& b
 	bidFutures.reserve(bids.size());
 
 	for (const auto& [price, orders] : bids) {
-		bidFutures.push_back(pool.submit(CreateLevelInfos, price, orders));
+		bidFutures.push_back(pool.submit(CreateLevelInfos, price, std::cref(orders)));
 	}
 
 	LevelInfos bidInfos;
@@ -524,7 +817,7 @@ OrderbookLevelInfos Orderbook::AsyncThreadPoolSnapshot::Generate(const BidMap& b
 	askFutures.reserve(asks.size());
 
 	for (const auto& [price, orders] : asks) {
-		askFutures.push_back(pool.submit(CreateLevelInfos, price, orders));
+		askFutures.push_back(pool.submit(CreateLevelInfos, price, std::cref(orders)));
 	}
 
 	LevelInfos askInfos;
@@ -535,3 +828,99 @@ OrderbookLevelInfos Orderbook::AsyncThreadPoolSnapshot::Generate(const BidMap& b
 
 	return OrderbookLevelInfos{ bidInfos, askInfos };
 }
+
+/* Generates a snapshot of the aggregated orderbook, with each side split into chunks summed in parallel on a work-stealing pool.
+ * Runs in O(N) where N is the total amount of orders.
+ */
+OrderbookLevelInfos OrderbookSnapshotStrategies::ThreadPoolSnapshot::Generate(const BidMap& bids, const AskMap& asks, WorkStealingThreadPool& pool) const {
+	auto generateSide = [&pool](const auto& levels) {
+		LevelInfos infos(levels.size());
+
+		pool.parallel_for(levels.begin(), levels.end(), [&infos](auto first, auto last, size_t offset) {
+			for (auto it = first; it != last; ++it, ++offset) {
+				const auto& [price, orders] = *it;
+
+				Quantity total = 0;
+				for (const auto& order : orders)
+					total += order.GetRemainingQuantity();
+
+				infos[offset] = LevelInfo{ price, total };
+			}
+		});
+
+		return infos;
+	};
+
+	return OrderbookLevelInfos{ generateSide(bids), generateSide(asks) };
+}
+
+/* Generates a snapshot of the aggregated orderbook, submitting one task per price level to a work-stealing pool in a single bulk submission.
+ * Runs in O(N) where N is the total amount of orders.
+ */
+OrderbookLevelInfos OrderbookSnapshotStrategies::AsyncThreadPoolSnapshot::Generate(const BidMap& bids, const AskMap& asks, WorkStealingThreadPool& pool) const {
+	auto submitSide = [&pool](const auto& levels, LevelInfos& infos) {
+		std::vector<const OrderQueue*> queues;
+		queues.reserve(levels.size());
+		infos.resize(levels.size());
+
+		for (const auto& [price, orders] : levels) {
+			infos[queues.size()].price_ = price;
+			queues.push_back(&orders);
+		}
+
+		const size_t count = queues.size();
+
+		return pool.submit_bulk(count, [&infos, queues = std::move(queues)](size_t i) {
+			Quantity total = 0;
+			for (const auto& order : *queues[i])
+				total += order.GetRemainingQuantity();
+
+			infos[i].quantity_ = total;
+		});
+	};
+
+	LevelInfos bidInfos;
+	LevelInfos askInfos;
+
+	auto bidsDone = submitSide(bids, bidInfos);
+	auto asksDone = submitSide(asks, askInfos);
+
+	bidsDone.get();
+	asksDone.get();
+
+	return OrderbookLevelInfos{ bidInfos, askInfos };
+}
+
+/* Generates a snapshot of the aggregated orderbook from the level data maintained by UpdateLevelData,
+ * so no order is ever visited.
+ * Runs in O(M) where M is the amount of price levels.
+ */
+OrderbookLevelInfos OrderbookSnapshotStrategies::AggregateSnapshot::Generate(const BidMap& bids, const AskMap& asks, const LevelDataMap& levels) const {
+	LevelInfos bidInfos;
+	bidInfos.reserve(bids.size());
+	for (const auto& [price, _] : bids)
+		bidInfos.push_back(LevelInfo{ price, levels.at(price).quantity_ });
+
+	LevelInfos askInfos;
+	askInfos.reserve(asks.size());
+	for (const auto& [price, _] : asks)
+		askInfos.push_back(LevelInfo{ price, levels.at(price).quantity_ });
+
+	return { bidInfos, askInfos };
+}
+
+/* Generates a snapshot of the best depth levels of each side from the maintained level data.
+ * Runs in O(D) where D is the requested depth.
+ */
+void OrderbookSnapshotStrategies::AggregateSnapshot::Generate(const BidMap& bids, const AskMap& asks, const LevelDataMap& levels, std::size_t depth, OrderbookDepthInfos& infos) const {
+	infos.Clear();
+
+	for (auto it = bids.begin(); it != bids.end() && infos.GetBids().size() < depth; ++it)
+		infos.PushBid(LevelInfo{ it->first, levels.at(it->first).quantity_ });
+
+	for (auto it = asks.begin(); it != asks.end() && infos.GetAsks().size() < depth; ++it)
+		infos.PushAsk(LevelInfo{ it->first, levels.at(it->first).quantity_ });
+}
+
+template class BasicOrderbook<MutexPolicy>;
+template class BasicOrderbook<NoLockPolicy>;
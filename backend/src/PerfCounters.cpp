@@ -0,0 +1,118 @@
+#include "PerfCounters.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+	constexpr std::array<std::uint64_t, 3> PERF_EVENTS = {
+		PERF_COUNT_HW_CACHE_REFERENCES,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+	};
+
+	int OpenCounter(std::uint64_t event) {
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = event;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+}
+
+PerfCounters::PerfCounters() {
+	for (std::size_t i = 0; i < counters_.size(); ++i) {
+		counters_[i] = OpenCounter(PERF_EVENTS[i]);
+
+		if (counters_[i] == NO_COUNTER && error_ == 0)
+			error_ = errno;
+	}
+}
+
+PerfCounters::~PerfCounters() {
+	for (int counter : counters_) {
+		if (counter != NO_COUNTER)
+			close(counter);
+	}
+}
+
+bool PerfCounters::IsAvailable() const {
+	for (int counter : counters_) {
+		if (counter == NO_COUNTER)
+			return false;
+	}
+
+	return true;
+}
+
+const char* PerfCounters::GetUnavailableReason() const {
+	if (IsAvailable())
+		return nullptr;
+
+	switch (error_) {
+	case EACCES:
+	case EPERM:
+		return "perf_event_paranoid forbids access, run as root or lower /proc/sys/kernel/perf_event_paranoid to 2";
+	case ENOENT:
+	case ENODEV:
+	case EOPNOTSUPP:
+		return "the kernel exposes no hardware PMU, as in most containers";
+	default:
+		return std::strerror(error_);
+	}
+}
+
+void PerfCounters::Start() {
+	for (int counter : counters_) {
+		if (counter == NO_COUNTER)
+			continue;
+
+		ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+		ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+PerfCounters::Reading PerfCounters::Stop() {
+	std::array<std::uint64_t, 3> values{};
+
+	for (std::size_t i = 0; i < counters_.size(); ++i) {
+		if (counters_[i] == NO_COUNTER)
+			continue;
+
+		ioctl(counters_[i], PERF_EVENT_IOC_DISABLE, 0);
+		if (read(counters_[i], &values[i], sizeof(values[i])) != sizeof(values[i]))
+			values[i] = 0;
+	}
+
+	return Reading{ values[0], values[1], values[2] };
+}
+#else
+PerfCounters::PerfCounters() {
+	counters_.fill(NO_COUNTER);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+bool PerfCounters::IsAvailable() const {
+	return false;
+}
+
+const char* PerfCounters::GetUnavailableReason() const {
+	return "hardware counters are only read on Linux, see PerfCounters.h for the build that collects them";
+}
+
+void PerfCounters::Start() {}
+
+PerfCounters::Reading PerfCounters::Stop() {
+	return {};
+}
+#endif
@@ -0,0 +1,202 @@
+#include <charconv>
+#include <format>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ReplayTool.h"
+#include "ReplayDriver.h"
+#include "OrderJournal.h"
+#include "OrderFlowGenerator.h"
+#include "Benchmark.h"
+#include "Orderbook.h"
+#include "LadderOrderbook.h"
+#include "BinarySearchOrderbook.h"
+#include "VanillaOrderbook.h"
+
+namespace {
+	// Fixtures carry no timestamps, so their commands are spaced evenly.
+	constexpr std::uint64_t FIXTURE_COMMAND_INTERVAL_NS = 1'000;
+	// Recorded flows arrive as a Poisson process with this mean gap.
+	constexpr double RECORD_MEAN_INTERVAL_NS = 1'000;
+	constexpr std::size_t RECORD_MIN_LIVE_ORDERS = 10'000;
+
+	std::vector<std::string_view> SplitColumns(std::string_view line) {
+		std::vector<std::string_view> columns;
+
+		for (std::size_t start = 0; start <= line.size();) {
+			const auto end = std::min(line.find(' ', start), line.size());
+			columns.push_back(line.substr(start, end - start));
+			start = end + 1;
+		}
+
+		return columns;
+	}
+
+	std::uint64_t ParseNumber(std::string_view column) {
+		std::uint64_t value{};
+		const auto [end, error] = std::from_chars(column.data(), column.data() + column.size(), value);
+
+		if (error != std::errc{} || end != column.data() + column.size())
+			throw std::runtime_error(std::format("Invalid number: {}", column));
+
+		return value;
+	}
+
+	Side ParseSide(std::string_view column) {
+		if (column == "B") return Side::Buy;
+		if (column == "S") return Side::Sell;
+		throw std::runtime_error(std::format("Unknown side: {}", column));
+	}
+
+	OrderType ParseOrderType(std::string_view column) {
+		if (column == "GoodTillCancel") return OrderType::GoodTillCancel;
+		if (column == "FillAndKill") return OrderType::FillAndKill;
+		if (column == "FillOrKill") return OrderType::FillOrKill;
+		if (column == "GoodForDay") return OrderType::GoodForDay;
+		if (column == "Market") return OrderType::Market;
+		throw std::runtime_error(std::format("Unknown order type: {}", column));
+	}
+
+	/* Parses the updates of an OrderbookTest fixture, up to its result line, into commands:
+	 *     A <side> <order type> <price> <quantity> <order id>
+	 *     M <order id> <side> <price> <quantity>
+	 *     C <order id>
+	 */
+	std::vector<OrderCommand> ParseFixture(const std::filesystem::path& path) {
+		std::ifstream file{ path };
+		if (!file)
+			throw std::runtime_error(std::format("Fixture ({}) cannot be opened.", path.string()));
+
+		std::vector<OrderCommand> commands;
+		std::string line;
+
+		while (std::getline(file, line) && !line.empty() && line[0] != 'R') {
+			const auto columns = SplitColumns(line);
+			OrderCommand command{ OrderCommandType::Add, OrderType::GoodTillCancel, Side::Buy, 0, 0, 0, 0 };
+
+			if (columns[0] == "A" && columns.size() == 6) {
+				command.side_ = ParseSide(columns[1]);
+				command.orderType_ = ParseOrderType(columns[2]);
+				command.price_ = ParseNumber(columns[3]);
+				command.quantity_ = ParseNumber(columns[4]);
+				command.orderId_ = ParseNumber(columns[5]);
+			} else if (columns[0] == "M" && columns.size() == 5) {
+				command.type_ = OrderCommandType::Modify;
+				command.orderId_ = ParseNumber(columns[1]);
+				command.side_ = ParseSide(columns[2]);
+				command.price_ = ParseNumber(columns[3]);
+				command.quantity_ = ParseNumber(columns[4]);
+			} else if (columns[0] == "C" && columns.size() == 2) {
+				command.type_ = OrderCommandType::Cancel;
+				command.orderId_ = ParseNumber(columns[1]);
+			} else {
+				throw std::runtime_error(std::format("Invalid update: {}", line));
+			}
+
+			commands.push_back(command);
+		}
+
+		return commands;
+	}
+
+	int Convert(const std::filesystem::path& fixture, const std::filesystem::path& journal) {
+		const auto commands = ParseFixture(fixture);
+		OrderJournalWriter writer{ journal };
+
+		for (std::size_t i = 0; i < commands.size(); ++i)
+			writer.Write(JournalEntry{ i * FIXTURE_COMMAND_INTERVAL_NS, commands[i] });
+		writer.Flush();
+
+		std::cout << "Converted " << commands.size() << " commands of " << fixture.string() << " into " << journal.string() << "\n";
+		return 0;
+	}
+
+	/* Runs the generator with trade feedback from a book of its own, so the journal holds exactly the flow it would
+	 * feed any correctly matching book.
+	 */
+	int Record(std::size_t count, const std::filesystem::path& journal) {
+		OrderFlowGenerator::Config config;
+		config.minLiveOrders_ = RECORD_MIN_LIVE_ORDERS;
+
+		OrderFlowGenerator generator{ config };
+		UnsyncOrderbook orderbook;
+		OrderJournalWriter writer{ journal };
+
+		std::mt19937_64 rng(config.seed_);
+		std::exponential_distribution<double> gapDist(1.0 / RECORD_MEAN_INTERVAL_NS);
+		double timestamp = 0;
+
+		for (std::size_t i = 0; i < count; ++i) {
+			const OrderCommand command = generator.Next();
+
+			writer.Write(JournalEntry{ static_cast<std::uint64_t>(timestamp), command });
+			generator.OnTrades(ApplyOrderCommand(orderbook, command));
+			timestamp += gapDist(rng);
+		}
+		writer.Flush();
+
+		std::cout << "Recorded " << count << " generated commands into " << journal.string() << "\n";
+		return 0;
+	}
+
+	template <typename OrderbookType>
+	void ReplayInto(const std::string& label, const JournalEntries& entries, ReplayPace pace) {
+		OrderbookType orderbook;
+		const auto result = ReplayJournal(orderbook, entries, pace);
+		const double seconds = std::max(1e-9, std::chrono::duration<double>(result.duration_).count());
+
+		std::cout << "Replayed " << result.commands_ << " commands into " << label << (pace == ReplayPace::Recorded ? " at recorded pace" : " at max speed")
+			<< " in " << std::chrono::duration_cast<std::chrono::milliseconds>(result.duration_).count() << "ms (" << result.trades_ << " trades, "
+			<< orderbook.Size() << " resting orders left)\n";
+		std::cout << "Throughput: " << result.commands_ / seconds << " commands/sec\n";
+		printLatencyPercentiles(result.latencies_);
+	}
+
+	int Replay(const std::filesystem::path& journal, std::string_view book, std::string_view paceName) {
+		ReplayPace pace;
+		if (paceName == "max") pace = ReplayPace::MaxSpeed;
+		else if (paceName == "recorded") pace = ReplayPace::Recorded;
+		else throw std::runtime_error(std::format("Unknown pace: {}", paceName));
+
+		const auto entries = OrderJournalReader::ReadAll(journal);
+
+		if (book == "orderbook") ReplayInto<Orderbook>("Orderbook", entries, pace);
+		else if (book == "unsync") ReplayInto<UnsyncOrderbook>("UnsyncOrderbook", entries, pace);
+		else if (book == "ladder") ReplayInto<LadderOrderbook>("LadderOrderbook", entries, pace);
+		else if (book == "binary") ReplayInto<BinarySearchOrderbook>("BinarySearchOrderbook", entries, pace);
+		else if (book == "vanilla") ReplayInto<VanillaOrderbook>("VanillaOrderbook", entries, pace);
+		else throw std::runtime_error(std::format("Unknown book: {}", book));
+
+		return 0;
+	}
+
+	int PrintUsage() {
+		std::cerr << "Usage:\n"
+			<< "  convert <fixture> <journal>\n"
+			<< "  record <count> <journal>\n"
+			<< "  replay <journal> [orderbook|unsync|ladder|binary|vanilla] [max|recorded]\n";
+		return 1;
+	}
+}
+
+int runReplayTool(std::span<char* const> args) {
+	const std::vector<std::string_view> arguments(args.begin(), args.end());
+
+	try {
+		if (arguments.size() == 3 && arguments[0] == "convert")
+			return Convert(arguments[1], arguments[2]);
+		if (arguments.size() == 3 && arguments[0] == "record")
+			return Record(ParseNumber(arguments[1]), arguments[2]);
+		if (arguments.size() >= 2 && arguments.size() <= 4 && arguments[0] == "replay")
+			return Replay(arguments[1], arguments.size() > 2 ? arguments[2] : "orderbook", arguments.size() > 3 ? arguments[3] : "max");
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+
+	return PrintUsage();
+}
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+#include "SimdKernels.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SIMD_KERNELS_X86
+#include <immintrin.h>
+
+// MSVC compiles any intrinsic without per-function target flags, GCC and Clang need them to emit wider instructions.
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX512
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+#endif
+
+namespace {
+	// Below one AVX-512 vector of values, setting up the vector loop costs more than it saves.
+	constexpr std::size_t MIN_VECTOR_COUNT = 8;
+
+	template <bool IsMax>
+	std::size_t FindExtremeScalar(const Price* prices, std::size_t count) {
+		if constexpr (IsMax)
+			return static_cast<std::size_t>(std::max_element(prices, prices + count) - prices);
+		else
+			return static_cast<std::size_t>(std::min_element(prices, prices + count) - prices);
+	}
+
+#if defined(SIMD_KERNELS_X86)
+	SIMD_TARGET_AVX2 std::size_t FindFirstAvx2(const Price* prices, std::size_t count, Price price) {
+		const __m256i target = _mm256_set1_epi64x(static_cast<long long>(price));
+		std::size_t i = 0;
+
+		for (; i + 4 <= count; i += 4) {
+			const __m256i equal = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(prices + i)), target);
+			if (const int mask = _mm256_movemask_pd(_mm256_castsi256_pd(equal)))
+				return i + std::countr_zero(static_cast<unsigned>(mask));
+		}
+
+		for (; i < count; ++i) {
+			if (prices[i] == price)
+				return i;
+		}
+
+		return count;
+	}
+
+	/* AVX2 only compares signed 64-bit lanes, so prices are biased by the sign bit to keep their unsigned order.
+	 */
+	template <bool IsMax>
+	SIMD_TARGET_AVX2 std::size_t FindExtremeAvx2(const Price* prices, std::size_t count) {
+		if (count < 4)
+			return FindExtremeScalar<IsMax>(prices, count);
+
+		const __m256i bias = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+		__m256i best = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(prices)), bias);
+		std::size_t i = 4;
+
+		for (; i + 4 <= count; i += 4) {
+			const __m256i values = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(prices + i)), bias);
+			const __m256i better = IsMax ? _mm256_cmpgt_epi64(values, best) : _mm256_cmpgt_epi64(best, values);
+			best = _mm256_blendv_epi8(best, values, better);
+		}
+
+		alignas(32) std::uint64_t lanes[4];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_xor_si256(best, bias));
+
+		Price extreme = lanes[0];
+		for (const Price price : { lanes[1], lanes[2], lanes[3] })
+			extreme = IsMax ? std::max(extreme, price) : std::min(extreme, price);
+		for (; i < count; ++i)
+			extreme = IsMax ? std::max(extreme, prices[i]) : std::min(extreme, prices[i]);
+
+		return FindFirstAvx2(prices, count, extreme);
+	}
+
+	SIMD_TARGET_AVX512 std::size_t FindFirstAvx512(const Price* prices, std::size_t count, Price price) {
+		const __m512i target = _mm512_set1_epi64(static_cast<long long>(price));
+
+		for (std::size_t i = 0; i < count; i += 8) {
+			const auto mask = static_cast<__mmask8>(count - i >= 8 ? 0xFF : (1u << (count - i)) - 1);
+			const __mmask8 equal = _mm512_mask_cmpeq_epu64_mask(mask, _mm512_maskz_loadu_epi64(mask, prices + i), target);
+
+			if (equal)
+				return i + std::countr_zero(static_cast<unsigned>(equal));
+		}
+
+		return count;
+	}
+
+	template <bool IsMax>
+	SIMD_TARGET_AVX512 std::size_t FindExtremeAvx512(const Price* prices, std::size_t count) {
+		if (count == 0)
+			return 0;
+
+		// Lanes past the end are filled with a value that never wins.
+		const __m512i neutral = _mm512_set1_epi64(IsMax ? 0 : -1);
+		__m512i best = neutral;
+
+		for (std::size_t i = 0; i < count; i += 8) {
+			const auto mask = static_cast<__mmask8>(count - i >= 8 ? 0xFF : (1u << (count - i)) - 1);
+			const __m512i values = _mm512_mask_loadu_epi64(neutral, mask, prices + i);
+			best = IsMax ? _mm512_max_epu64(best, values) : _mm512_min_epu64(best, values);
+		}
+
+		const Price extreme = IsMax ? _mm512_reduce_max_epu64(best) : _mm512_reduce_min_epu64(best);
+		return FindFirstAvx512(prices, count, extreme);
+	}
+#endif
+
+	SimdKernels::Level DetectLevel() {
+#if defined(SIMD_KERNELS_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return SimdKernels::Level::Scalar;
+
+		// The OS has to save the wider registers on context switches too, which XCR0 reports.
+		__cpuid(info, 1);
+		if (!((info[2] >> 27) & 1))
+			return SimdKernels::Level::Scalar;
+
+		const auto enabledState = _xgetbv(0);
+		__cpuidex(info, 7, 0);
+
+		if (((info[1] >> 16) & 1) && (enabledState & 0xE6) == 0xE6)
+			return SimdKernels::Level::Avx512;
+		if (((info[1] >> 5) & 1) && (enabledState & 0x6) == 0x6)
+			return SimdKernels::Level::Avx2;
+#else
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx512f"))
+			return SimdKernels::Level::Avx512;
+		if (__builtin_cpu_supports("avx2"))
+			return SimdKernels::Level::Avx2;
+#endif
+#endif
+		return SimdKernels::Level::Scalar;
+	}
+
+	template <bool IsMax>
+	std::size_t FindExtreme(const Price* prices, std::size_t count, SimdKernels::Level level) {
+#if defined(SIMD_KERNELS_X86)
+		if (count < MIN_VECTOR_COUNT)
+			return FindExtremeScalar<IsMax>(prices, count);
+
+		switch (std::min(level, SimdKernels::GetLevel())) {
+		case SimdKernels::Level::Avx512:
+			return FindExtremeAvx512<IsMax>(prices, count);
+		case SimdKernels::Level::Avx2:
+			return FindExtremeAvx2<IsMax>(prices, count);
+		default:
+			break;
+		}
+#endif
+		return FindExtremeScalar<IsMax>(prices, count);
+	}
+}
+
+SimdKernels::Level SimdKernels::GetLevel() {
+	static const Level level = DetectLevel();
+	return level;
+}
+
+const char* SimdKernels::GetLevelName(Level level) {
+	switch (level) {
+	case Level::Avx512:
+		return "AVX-512";
+	case Level::Avx2:
+		return "AVX2";
+	default:
+		return "scalar";
+	}
+}
+
+std::size_t SimdKernels::FindMinPrice(const Price* prices, std::size_t count) {
+	return FindMinPrice(prices, count, GetLevel());
+}
+
+/* Runs in O(N) where N is the amount of prices.
+ */
+std::size_t SimdKernels::FindMinPrice(const Price* prices, std::size_t count, Level level) {
+	return FindExtreme<false>(prices, count, level);
+}
+
+std::size_t SimdKernels::FindMaxPrice(const Price* prices, std::size_t count) {
+	return FindMaxPrice(prices, count, GetLevel());
+}
+
+/* Runs in O(N) where N is the amount of prices.
+ */
+std::size_t SimdKernels::FindMaxPrice(const Price* prices, std::size_t count, Level level) {
+	return FindExtreme<true>(prices, count, level);
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <limits>
 #include <numeric>
 #include <chrono>
 #include <ctime>
@@ -5,6 +7,58 @@
 #include <iostream>
 
 #include "VanillaOrderbook.h"
+#include "SimdKernels.h"
+
+namespace {
+	constexpr Price NO_ASK_PRICE = std::numeric_limits<Price>::max();
+	constexpr Price NO_BID_PRICE = std::numeric_limits<Price>::min();
+}
+
+/* Appends the given order together with its entries in the price arrays.
+ * Runs in amortized O(1).
+ */
+void VanillaOrderbook::PushOrder(OrderPointer order) {
+	askPrices_.push_back(order->GetSide() == Side::Sell ? order->GetPrice() : NO_ASK_PRICE);
+	bidPrices_.push_back(order->GetSide() == Side::Buy ? order->GetPrice() : NO_BID_PRICE);
+	orders_.push_back(std::move(order));
+}
+
+/* Erases every order matching the given predicate, keeping the price arrays in step and the remaining orders in time order.
+ * Runs in O(N) where N is the amount of orders.
+ */
+template <typename Predicate>
+void VanillaOrderbook::EraseOrders(Predicate predicate) {
+	std::size_t kept = 0;
+
+	for (std::size_t i = 0; i < orders_.size(); ++i) {
+		if (predicate(*orders_[i]))
+			continue;
+
+		if (kept != i) {
+			orders_[kept] = std::move(orders_[i]);
+			askPrices_[kept] = askPrices_[i];
+			bidPrices_[kept] = bidPrices_[i];
+		}
+
+		++kept;
+	}
+
+	orders_.resize(kept);
+	askPrices_.resize(kept);
+	bidPrices_.resize(kept);
+}
+
+/* Returns the order at the given index of a best price scan, or nullptr if the given side has no orders.
+ * The index lands on an order of the other side only when no order beats the parking price, in which case
+ * the first order of the given side, if any, is the best by time priority.
+ */
+const OrderPointer VanillaOrderbook::FindBestOrder(Side side, std::size_t index) const {
+	if (index < orders_.size() && orders_[index]->GetSide() == side)
+		return orders_[index];
+
+	auto it = std::find_if(orders_.begin(), orders_.end(), [side](const OrderPointer& o) { return o->GetSide() == side; });
+	return it == orders_.end() ? nullptr : *it;
+}
 
 /* Cancels all orders with the given order ids.
  * Runs in O(N^2), where N is the amount of given order ids.
@@ -18,46 +72,21 @@ void VanillaOrderbook::CancelOrders(OrderIds orderIds) {
  * Runs in O(N) where N is the amount of orders.
  */
 void VanillaOrderbook::CancelOrderInternal(OrderId orderId) {
-	orders_.erase(
-		std::remove_if(orders_.begin(), orders_.end(), [&](const auto& o) {
-			return o->GetOrderId() == orderId;
-		}),
-		orders_.end()
-	);
+	EraseOrders([&](const Order& o) { return o.GetOrderId() == orderId; });
 }
 
 /* Retrieves the order with the best ask given price-time priority or nullptr if there are none.
- * Runs in O(N) where N is the amount of orders.
+ * Runs in O(N) where N is the amount of orders, as a SIMD scan over the ask prices.
  */
 const OrderPointer VanillaOrderbook::getBestAsk() const {
-	OrderPointer bestAskOrder = nullptr;
-
-	for (const auto& order : orders_) {
-		if (!order || order->GetSide() != Side::Sell || order->GetRemainingQuantity() == 0) continue;
-
-		if (!bestAskOrder || order->GetPrice() < bestAskOrder->GetPrice()) {
-			bestAskOrder = order;
-		}
-	}
-
-	return bestAskOrder;
+	return FindBestOrder(Side::Sell, SimdKernels::FindMinPrice(askPrices_.data(), askPrices_.size()));
 }
 
 /* Retrieves the order with the best bid given price-time priority or nullptr if there are none.
- * Runs in O(N) where N is the amount of orders.
+ * Runs in O(N) where N is the amount of orders, as a SIMD scan over the bid prices.
  */
 const OrderPointer VanillaOrderbook::getBestBid() const {
-	OrderPointer bestBidOrder = nullptr;
-
-	for (const auto& order : orders_) {
-		if (!order || order->GetSide() != Side::Buy || order->GetRemainingQuantity() == 0) continue;
-
-		if (!bestBidOrder || order->GetPrice() > bestBidOrder->GetPrice()) {
-			bestBidOrder = order;
-		}
-	}
-
-	return bestBidOrder;
+	return FindBestOrder(Side::Buy, SimdKernels::FindMaxPrice(bidPrices_.data(), bidPrices_.size()));
 }
 
 /* Retrieves the order with the best ask given price-time priority or nullptr if there are none.
@@ -141,24 +170,8 @@ Trades VanillaOrderbook::MatchOrders() {
 	Trades trades;
 
 	while (true) {
-		OrderPointer bestBid = nullptr;
-		OrderPointer bestAsk = nullptr;
-
-		for (auto& order : orders_) {
-			if (!order || order->GetSide() != Side::Buy || order->GetRemainingQuantity() == 0) continue;
-
-			if (!bestBid || order->GetPrice() > bestBid->GetPrice()) {
-				bestBid = order;
-			}
-		}
-
-		for (auto& order : orders_) {
-			if (!order || order->GetSide() != Side::Sell || order->GetRemainingQuantity() == 0) continue;
-
-			if (!bestAsk || order->GetPrice() < bestAsk->GetPrice()) {
-				bestAsk = order;
-			}
-		}
+		const OrderPointer bestBid = getBestBid();
+		const OrderPointer bestAsk = getBestAsk();
 
 		if (!bestBid || !bestAsk || bestBid->GetPrice() < bestAsk->GetPrice()) break;
 
@@ -174,12 +187,7 @@ Trades VanillaOrderbook::MatchOrders() {
 			TradeInfo{ bestAsk->GetOrderId(), bestAsk->GetPrice(), quantity }
 		});
 
-		orders_.erase(
-			std::remove_if(orders_.begin(), orders_.end(), [](const auto& o) {
-				return o->IsFilled();
-			}),
-			orders_.end()
-		);
+		EraseOrders([](const Order& o) { return o.IsFilled(); });
 	}
 
 	return trades;
@@ -211,11 +219,17 @@ Trades VanillaOrderbook::AddOrder(OrderPointer order) {
 	if (order->GetOrderType() == OrderType::FillOrKill && !CanFullyFill(order->GetSide(), order->GetPrice(), order->GetInitialQuantity()))
 		return {};
 
-	orders_.push_back(order);
+	PushOrder(order);
 
 	return MatchOrders();
 }
 
+/* Adds an order built from the given fields to the orderbook.
+ */
+Trades VanillaOrderbook::AddOrder(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity) {
+	return AddOrder(std::make_shared<Order>(orderType, orderId, side, price, quantity));
+}
+
 /* Acquires a lock on the orders and then cancels the order with the given order id.
  * Runs in O(log(M)) where M is the number of distinct price levels.
  */
@@ -1,8 +1,15 @@
 #include "ThreadPool.h"
+#include "WorkStealingThreadPool.h"
 #include "Benchmark.h"
+#include "ReplayTool.h"
+
+int main(int argc, char** argv) {
+	// Any arguments select the journal tool instead of the benchmarks.
+	if (argc > 1)
+		return runReplayTool(std::span<char* const>(argv + 1, argc - 1));
 
-int main() {
 	ThreadPool pool(std::thread::hardware_concurrency());
-	runAllBenchmarks(pool);
+	WorkStealingThreadPool stealingPool(std::thread::hardware_concurrency());
+	runAllBenchmarks(pool, stealingPool);
 	return 0;
 }